@@ -68,4 +68,32 @@ function(uberton_set_plugin_version)
 	configure_file("${UBERTON_SRC_PATH}/src/common/source/version_release.in" "version.txt")
 	target_include_directories(${ARG_TARGET} PUBLIC ${CMAKE_CURRENT_BINARY_DIR})
     smtg_add_plugin_resource(${ARG_TARGET} "${CMAKE_CURRENT_BINARY_DIR}/version.txt" "Documentation") 
-endfunction()
\ No newline at end of file
+endfunction()
+
+
+# Real-time safety test of a plugin project target (only with UBERTON_RT_AUDIT): the plugin sources are linked into an
+# executable that sweeps the parameters of each processor over process() blocks and fails on any violation
+# (src/tools/rt_audit_test.cpp). Needs to be called after all sources have been added to the target.
+function(uberton_add_rt_audit_test)
+	set(args TARGET)
+    cmake_parse_arguments(PARSE_ARGV 0 ARG "${options}" "${args}" "${list_args}")
+	if(NOT UBERTON_RT_AUDIT)
+		return()
+	endif()
+
+	set(test_target ${ARG_TARGET}_rt_audit)
+	get_target_property(plugin_sources ${ARG_TARGET} SOURCES)
+	list(FILTER plugin_sources INCLUDE REGEX "\\.cpp$")
+	set(test_sources "${UBERTON_SRC_PATH}/src/tools/rt_audit_test.cpp")
+	foreach(source ${plugin_sources})
+		get_filename_component(absolute_source ${source} ABSOLUTE)
+		list(APPEND test_sources ${absolute_source})
+	endforeach()
+
+	add_executable(${test_target} ${test_sources})
+	set_target_properties(${test_target} PROPERTIES ${UBERTON_FOLDER})
+	target_include_directories(${test_target} PRIVATE $<TARGET_PROPERTY:${ARG_TARGET},INCLUDE_DIRECTORIES>)
+	target_compile_definitions(${test_target} PRIVATE $<TARGET_PROPERTY:${ARG_TARGET},COMPILE_DEFINITIONS>)
+	target_link_libraries(${test_target} PRIVATE $<TARGET_PROPERTY:${ARG_TARGET},LINK_LIBRARIES> sdk_hosting)
+	add_test(NAME ${test_target} COMMAND ${test_target})
+endfunction()
@@ -23,6 +23,7 @@ tresult PLUGIN_API Controller::initialize(FUnknown* context) {
 
 	setCurrentUnitID(rootUnitId);
 	addParam<LinearParameter>(ParamSpecs::vol, "Gain", "%");
+	addParam<LogParameter>(ParamSpecs::dampening, "Dampening", "Damp", "", Precision(2));
 
 	return kResultTrue;
 }
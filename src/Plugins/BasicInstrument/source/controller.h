@@ -12,6 +12,7 @@
 #pragma once
 
 #include <ControllerBase.h>
+#include <scan_timer.h>
 #include "ids.h"
 
 namespace Uberton {
@@ -25,7 +26,10 @@ public:
 	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE;
 	IPlugView* PLUGIN_API createView(FIDString name) SMTG_OVERRIDE;
 
-	static FUnknown* createInstance(void*) { return (Vst::IEditController*)new Controller(); }
+	static FUnknown* createInstance(void*) {
+		UBERTON_SCAN_TIMER("BasicInstrument controller construction");
+		return (Vst::IEditController*)new Controller();
+	}
 };
 
 }
@@ -22,11 +22,13 @@ namespace BasicInstrument {
 
 enum Params : Steinberg::Vst::ParamID {
 	kParamVol,
+	kParamDampening,
 	kNumGlobalParameters,
 };
 
 namespace ParamSpecs {
 static const LinearParamSpec vol{ kParamVol, 0, 1, 0.8, 0.8 };
+static const LogParamSpec dampening{ kParamDampening, 0, 10, 0.1, 0.1 };
 }
 using ParamState = UniformParamState<kNumGlobalParameters>;
 
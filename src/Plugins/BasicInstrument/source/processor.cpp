@@ -13,6 +13,8 @@
 
 #include <public.sdk/source/vst/vstaudioprocessoralgo.h>
 #include <vstmath.h>
+#include <algorithm>
+#include <cmath>
 
 namespace Uberton {
 namespace BasicInstrument {
@@ -27,10 +29,11 @@ Processor::Processor() {
 	};
 
 	initValue(ParamSpecs::vol);
+	initValue(ParamSpecs::dampening);
 }
 
 tresult PLUGIN_API Processor::initialize(FUnknown* context) {
-	tresult result = AudioEffect::initialize(context);
+	tresult result = ProcessorBase::initialize(context);
 	if (result != kResultTrue)
 		return kResultFalse;
 
@@ -41,13 +44,40 @@ tresult PLUGIN_API Processor::initialize(FUnknown* context) {
 }
 
 tresult PLUGIN_API Processor::setupProcessing(ProcessSetup& setup) {
-	osc.setSampleRate(setup.sampleRate);
+	sampleRate = setup.sampleRate;
+	pitchTables.prepare(pitchTableSettings());
+
 	resonator.setSampleRate(setup.sampleRate);
 	resonator.setInputPositions({ .3 });
 	resonator.setOutputPositions({ .7 });
+	for (int i = 0; i < numModes; i++) {
+		excitation[i] = .5f * resonator.inputPosEF[0][i];
+	}
+	releaseDecay = std::exp(-releaseDampening / static_cast<float>(setup.sampleRate));
+
+	voices.reset();
+	for (int v = 0; v < maxVoices; v++) {
+		voices[v].group = v / voicesPerGroup;
+		voices[v].lane = v % voicesPerGroup;
+	}
+	for (auto& group : groups) {
+		group.clear();
+		for (int lane = 0; lane < voicesPerGroup; lane++) {
+			group.setOutputWeights(lane, resonator.outputPosEF[0].data());
+		}
+	}
 	return ProcessorBase::setupProcessing(setup);
 }
 
+tresult PLUGIN_API Processor::setActive(TBool state) {
+	// the pitch table worker only serves process()
+	if (state)
+		pitchTables.start();
+	else
+		pitchTables.stop();
+	return ProcessorBase::setActive(state);
+}
+
 void Processor::processAudio(ProcessData& data) {
 	int32 numChannels = data.outputs[0].numChannels;
 	int32 numSamples = data.numSamples;
@@ -55,21 +85,95 @@ void Processor::processAudio(ProcessData& data) {
 	Sample32** out = data.outputs[0].channelBuffers32;
 	float volume = paramState.params[kParamVol];
 
-	if (playing) {
-		for (int32 i = 0; i < numSamples; i++) {
-			float sample = osc.get();
-			sample = resonator.next()[0];
-
-			for (int32 channel = 0; channel < numChannels; channel++) {
-				out[channel][i] = sample * volume;
+	if (voices.getNumActive() > 0 || !noteEvents.empty()) {
+		// The voices are rendered in segments between the note events (sample accurate timing).
+		// Only groups with sounding voices are rendered.
+		std::array<bool, numGroups> rendered{};
+		std::fill(out[0], out[0] + numSamples, 0.f);
+		noteEvents.process(
+			numSamples,
+			[&](int start, int end) {
+				std::array<bool, numGroups> sounding{};
+				voices.forEachActive([&](Voice& voice) { sounding[voice.group] = true; });
+				for (int g = 0; g < numGroups; g++) {
+					if (!sounding[g]) continue;
+					groups[g].render(out[0] + start, end - start);
+					rendered[g] = true;
+				}
+			},
+			[&](const NoteEvent& event) { applyNoteEvent(event); });
+
+		voices.forEachActive([&](Voice& voice) { voice.level = groups[voice.group].energy(voice.lane); });
+		voices.freeIf([](const Voice& voice) { return voice.energy() < silenceEnergy; });
+		// the lanes of freed voices must not ring on in a group that is still rendered
+		for (int v = 0; v < maxVoices; v++) {
+			if (rendered[voices[v].group] && !voices.isActive(v)) {
+				groups[voices[v].group].clear(voices[v].lane);
 			}
 		}
+
+		for (int32 i = 0; i < numSamples; i++) {
+			out[0][i] *= volume;
+		}
+		for (int32 channel = 1; channel < numChannels; channel++) {
+			std::copy(out[0], out[0] + numSamples, out[channel]);
+		}
 	}
 	else {
 		Algo::clear32(data.outputs, numSamples);
 	}
 }
 
+void Processor::applyNoteEvent(const NoteEvent& event) {
+	// velocity 0 is a note off
+	if (event.velocity > 0)
+		noteOn(event.pitch);
+	else
+		noteOff(event.pitch);
+}
+
+void Processor::noteOn(int pitch) {
+	bool retriggered;
+	const int v = voices.noteOn(pitch, retriggered);
+	if (v == voices.noVoice) return;
+
+	Voice& voice = voices[v];
+	VoiceGroup& group = groups[voice.group];
+	voice.pitch = pitch;
+	voice.released = false;
+	group.setTimeFunctions(voice.lane, pitchTables.table()[pitch]);
+	if (!retriggered) {
+		group.clear(voice.lane); // new or stolen voice
+	}
+	group.excite(voice.lane, excitation.data());
+	voice.level = group.energy(voice.lane);
+}
+
+void Processor::noteOff(int pitch) {
+	const int v = voices.noteOff(pitch);
+	if (v == voices.noVoice) return;
+
+	// the voice rings out with the additional release dampening until it is silent
+	voices[v].released = true;
+	groups[voices[v].group].dampen(voices[v].lane, releaseDecay);
+}
+
+Processor::PitchTables::Settings Processor::pitchTableSettings() {
+	return { static_cast<float>(sampleRate), static_cast<float>(toScaled(ParamSpecs::dampening)), velocity };
+}
+
+void Processor::updatePitchTables() {
+	if (!pitchTables.update()) return;
+
+	// sounding voices continue with the new dampening
+	const auto& table = pitchTables.table();
+	voices.forEachActive([&](Voice& voice) {
+		VoiceGroup& group = groups[voice.group];
+		group.setTimeFunctions(voice.lane, table[voice.pitch]);
+		if (voice.released) group.dampen(voice.lane, releaseDecay);
+	});
+}
+
 void Processor::processParameterChanges(IParameterChanges* inputParameterChanges) {
 	Algo::foreach (inputParameterChanges, [&](IParamValueQueue& paramQueue) {
 		Algo::foreachLast(paramQueue, [&](int32 id, int32 sampleOffset, ParamValue value) {
@@ -78,26 +182,34 @@ void Processor::processParameterChanges(IParameterChanges* inputParameterChanges
 				paramState.bypass = value > 0.5f;
 			}
 			else
-				paramState.params[id] = value;
+				paramState.set(id, value);
 		}
 
 		);
 	});
+	// also picks up dampening changes from setState()
+	paramState.forEachDirty([&](int32 id) {
+		switch (id) {
+		case Params::kParamDampening: pitchTables.request(pitchTableSettings()); break;
+		}
+	});
+	updatePitchTables();
 }
 
 void Processor::processEvents(IEventList* eventList) {
+	auto apply = [&](const NoteEvent& event) { applyNoteEvent(event); };
+	// events of the last block that has not been rendered (i.e. bypassed) are applied right away
+	noteEvents.flush(apply);
+
+	// the note events are applied in processAudio() at their sample offsets
+	auto queue = [&](const NoteEvent& event) { noteEvents.push(event, apply); };
 	Algo::foreach (eventList, [&](const Event& event) {
 		switch (event.type) {
 		case Event::kNoteOnEvent:
-			playing = true;
-			osc.setPhase(0.0);
-			osc.setFrequency(Math::frequencyTable[event.noteOn.pitch]);
-			resonator.setFreqDampeningAndVelocity(Math::frequencyTable[event.noteOn.pitch], .1, 10);
-			resonator.delta({ .5 });
+			queue({ event.sampleOffset, event.noteOn.pitch, event.noteOn.velocity });
 			break;
 		case Event::kNoteOffEvent:
-			//playing = false;
-
+			queue({ event.sampleOffset, event.noteOff.pitch, 0.f });
 			break;
 		case Event::kNoteExpressionValueEvent:
 			break;
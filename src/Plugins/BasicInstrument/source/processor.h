@@ -12,8 +12,10 @@
 #pragma once
 
 #include <ProcessorBase.h>
-#include <oscillators.h>
 #include <resonator.h>
+#include <resonator_voices.h>
+#include <pitch_tables.h>
+#include <voices.h>
 #include "ids.h"
 
 
@@ -28,18 +30,64 @@ public:
 	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE;
 	tresult PLUGIN_API setBusArrangements(SpeakerArrangement* inputs, int32 numIns, SpeakerArrangement* outputs, int32 numOuts) SMTG_OVERRIDE;
 	tresult PLUGIN_API setupProcessing(ProcessSetup& setup) SMTG_OVERRIDE;
+	tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
 
 	void processAudio(ProcessData& data) override;
 	void processEvents(IEventList* eventList) override;
 	void processParameterChanges(IParameterChanges* parameterChanges) override;
 
-	static FUnknown* createInstance(void*) { return (Vst::IAudioProcessor*)new Processor(); }
+	static FUnknown* createInstance(void*) {
+		UBERTON_SCAN_TIMER("BasicInstrument processor construction");
+		return (Vst::IAudioProcessor*)new Processor();
+	}
 
 
 protected:
-	bool playing{ false };
-	SineOscillatorPow5 osc;
-	Math::CubeResonator<float, 1, 5, 1> resonator;
+	using Resonator = Math::CubeResonator<float, 1, 5, 1>;
+	using scalar = Resonator::scalar;
+	static constexpr int numModes = Resonator::maxOrder();
+	static constexpr int voicesPerGroup = 8; // SIMD lanes
+	static constexpr int numGroups = 4;
+	static constexpr int maxVoices = voicesPerGroup * numGroups;
+
+	static constexpr float velocity = 10;
+	static constexpr float releaseDampening = 20;  // additional dampening after note off
+	static constexpr float silenceEnergy = 1e-10f; // voices below are freed
+
+	using VoiceGroup = Math::ResonatorVoiceGroup<Resonator, voicesPerGroup>;
+	using PitchTables = Math::PitchTables<Resonator>;
+
+	// One sounding note. The time steps per pitch and the eigenfunctions at the input and output
+	// positions are shared by all voices. The modal amplitudes and time steps of a voice live in
+	// a lane of a voice group, so that a whole group is rendered at once.
+	struct Voice
+	{
+		int group{ 0 };
+		int lane{ 0 };
+		int pitch{ 0 };
+		bool released{ false };
+		float level{ 0 }; // modal energy at the end of the last block
+
+		float energy() const { return level; }
+	};
+
+	void applyNoteEvent(const NoteEvent& event);
+	void noteOn(int pitch);
+	void noteOff(int pitch);
+	// Switch to finished time step tables (requested when the dampening changes)
+	void updatePitchTables();
+	PitchTables::Settings pitchTableSettings();
+
+	VoicePool<Voice, maxVoices> voices;
+	NoteEventQueue<512> noteEvents; // note events of the current block
+	std::array<VoiceGroup, numGroups> groups;
+	Resonator resonator;	 // shared position eigenfunctions
+	PitchTables pitchTables; // time steps of all pitches, so note on is a table lookup
+	double sampleRate{ 44100 };
+
+	// precomputed in setupProcessing(), so that note events do not evaluate eigenfunctions
+	std::array<scalar, numModes> excitation{}; // added to the amplitudes on note on
+	float releaseDecay{ 1 };				   // per sample
 };
 
 }
@@ -11,6 +11,7 @@
 
 #include "controller.h"
 #include <ui.h>
+#include <scan_timer.h>
 
 namespace Uberton {
 namespace ResonatorPlugin {
@@ -63,6 +64,7 @@ void Controller::updateResonatorSizeDisplay() {
 }
 
 FUnknown* createControllerInstance(void*) {
+	UBERTON_SCAN_TIMER("Hypersphere controller construction");
 	return static_cast<IEditController*>(new Controller);
 }
 
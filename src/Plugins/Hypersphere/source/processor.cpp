@@ -18,6 +18,10 @@ namespace Uberton {
 namespace ResonatorPlugin {
 namespace Hypersphere {
 
+// Stereo input positions, one output position per output channel
+template<class T, int outputs>
+using Resonator = Math::NSphereResonator<T, maxDimension, maxOrder, 2, outputs>;
+
 Processor::Processor() {
 	setControllerClass(ControllerUID);
 
@@ -35,38 +39,40 @@ Processor::Processor() {
 		paramState[Params::kParamOutL0 + i] = 0;
 		paramState[Params::kParamOutR0 + i] = 0;
 	}
-}
-
-tresult PLUGIN_API Processor::setActive(TBool state) {
-	if (state) {
-		if (processSetup.symbolicSampleSize == kSample32) {
-			processorImpl = std::make_unique<SphereProcessorImpl<Math::NSphereResonator<float, maxDimension, maxOrder, 2>, float>>();
-			Math::PreComputedCubeResonator<float, maxDimension, maxOrder, 2> a;
+	for (int ch = 2; ch < maxOutputChannels; ch++) {
+		for (int i = 0; i < maxDimension; i++) {
+			paramState[outputPositionParam(ch, i)] = 0;
 		}
-		else {
-			processorImpl = std::make_unique<SphereProcessorImpl<Math::NSphereResonator<double, maxDimension, maxOrder, 2>, double>>();
-		}
-		processorImpl->init(processSetup.sampleRate);
-		recomputeParameters();
 	}
-	else {
-		processorImpl.reset();
-		sendMessageID(processorDeactivatedMsgID);
+}
+
+std::unique_ptr<ProcessorImplBase> Processor::makeProcessorImpl(int32 symbolicSampleSize) const {
+	if (symbolicSampleSize == kSample32) {
+		return createProcessorImpl<SphereProcessorImpl, Resonator, float>(configuration);
 	}
-	return kResultTrue;
+	return createProcessorImpl<SphereProcessorImpl, Resonator, double>(configuration);
 }
 
-void Processor::recomputeInexpensiveParameters() {
-	resonatorOrder = toDiscrete(ParamSpecs::resonatorOrder);
-	ResonatorProcessorBase::recomputeInexpensiveParameters();
+void Processor::updateResonatorOrder() {
+	resonatorOrder = orderOf(paramState);
+	ResonatorProcessorBase::updateResonatorOrder();
 }
 
 void Processor::updateResonatorDimension() {
-	resonatorDim = toDiscrete(ParamSpecs::resonatorDim);
+	resonatorDim = dimensionOf(paramState);
 	ResonatorProcessorBase::updateResonatorDimension();
 }
 
+int Processor::dimensionOf(const ParamState& state) const {
+	return ParamSpecs::resonatorDim.toDiscrete(state[Params::kParamResonatorDim]);
+}
+
+int Processor::orderOf(const ParamState& state) const {
+	return ParamSpecs::resonatorOrder.toDiscrete(state[Params::kParamResonatorOrder]);
+}
+
 FUnknown* createProcessorInstance(void*) {
+	UBERTON_SCAN_TIMER("Hypersphere processor construction");
 	return static_cast<IAudioProcessor*>(new Processor);
 }
 } // namespace Hypersphere
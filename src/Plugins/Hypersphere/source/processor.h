@@ -24,48 +24,33 @@ class Processor : public ResonatorProcessorBase
 public:
 	Processor();
 
-	tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
-
 
 private:
+	std::unique_ptr<ProcessorImplBase> makeProcessorImpl(int32 symbolicSampleSize) const override;
 	void updateResonatorDimension() override;
-	void recomputeInexpensiveParameters() override;
+	void updateResonatorOrder() override;
+	int dimensionOf(const ParamState& state) const override;
+	int orderOf(const ParamState& state) const override;
 };
 
-template<class Resonator, typename SampleType, int numChannels = 2>
-class SphereProcessorImpl : public ProcessorImpl<Resonator, SampleType, numChannels>
+template<class Resonator, typename SampleType, Configuration configuration = Configuration::Stereo>
+class SphereProcessorImpl : public ProcessorImpl<Resonator, SampleType, configuration>
 {
-	void updateResonatorInputPosition(const ParamState& paramState) override {
-		InputVecArr inputPositions;
-		int d = static_cast<int>(inputPositions[0].size());
-		for (int i = 0; i < d; i++) {
-			inputPositions[0][i] = paramState[Params::kParamOutL0 + i];
-			if constexpr (numChannels > 1)
-				inputPositions[1][i] = paramState[Params::kParamOutR0 + i];
-		}
-		inputPositions[0] += inputPosSpaceCurveSphere(paramState[Params::kParamInPosCurveL]);
-		if constexpr (numChannels > 1)
-			inputPositions[1] += inputPosSpaceCurveSphere(paramState[Params::kParamInPosCurveR]);
-		resonator.setInputPositions(inputPositions);
-	}
+	using Base = ProcessorImpl<Resonator, SampleType, configuration>;
+	using typename Base::SpaceVec;
 
-	void updateResonatorOutputPosition(const ParamState& paramState) override {
-		InputVecArr outputPositions;
-		int d = static_cast<int>(outputPositions[0].size());
-		for (int i = 0; i < d; i++) {
-			outputPositions[0][i] = paramState[Params::kParamOutL0 + i];
-			if constexpr (numChannels > 1)
-				outputPositions[1][i] = paramState[Params::kParamOutR0 + i];
-		}
-		outputPositions[0] += outputPosSpaceCurveSphere(paramState[Params::kParamOutPosCurveL]);
-		if constexpr (numChannels > 1)
-			outputPositions[1] += outputPosSpaceCurveSphere(paramState[Params::kParamOutPosCurveR]);
-		resonator.setOutputPositions(outputPositions);
+	using typename Base::Job;
+	using typename Base::Curve;
+
+	Curve spaceCurves() const override {
+		return [](Job job, double t) {
+			return job == Base::Worker::InputPositions ? inputPosSpaceCurveSphere(t) : outputPosSpaceCurveSphere(t);
+		};
 	}
 
 protected:
 	// t in [0,1]; returns [1, π, π/2, π/2, π/2... ] for t = 0.5
-	SpaceVec inputPosSpaceCurveSphere(ParamValue t) const {
+	static SpaceVec inputPosSpaceCurveSphere(ParamValue t) {
 		constexpr float pi = Math::pi<SampleType>();
 		const SampleType r = (t * 2) * (t * 2);
 		const SampleType phi = 2 * pi * t;
@@ -87,8 +72,8 @@ protected:
 	}
 
 	// t in [0,1]; returns [1, π, π/2, π/2, π/2... ] for t = 0.5
-	SpaceVec outputPosSpaceCurveSphere(ParamValue t) const {
-		return inputPosSpaceCurve(t);
+	static SpaceVec outputPosSpaceCurveSphere(ParamValue t) {
+		return Base::inputPosSpaceCurve(t);
 	}
 
 };
@@ -22,7 +22,7 @@ Processor::Processor() {
 
 tresult PLUGIN_API Processor::initialize(FUnknown* context) {
 	//---always initialize the parent-------
-	tresult result = AudioEffect::initialize(context);
+	tresult result = ProcessorBase::initialize(context);
 	if (result != kResultTrue)
 		return kResultFalse;
 
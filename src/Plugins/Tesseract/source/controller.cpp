@@ -11,6 +11,7 @@
 
 #include "controller.h"
 #include <ui.h>
+#include <scan_timer.h>
 
 namespace Uberton {
 namespace ResonatorPlugin {
@@ -61,6 +62,7 @@ void Controller::updateResonatorSizeDisplay() {
 }
 
 FUnknown* createControllerInstance(void*) {
+	UBERTON_SCAN_TIMER("Tesseract controller construction");
 	return static_cast<IEditController*>(new Controller);
 }
 
@@ -18,6 +18,10 @@ namespace Uberton {
 namespace ResonatorPlugin {
 namespace Tesseract {
 
+// Stereo input positions, one output position per output channel
+template<class T, int outputs>
+using Resonator = Math::PreComputedCubeResonator<T, maxDimension, maxOrder, 2, outputs>;
+
 Processor::Processor() {
 	setControllerClass(ControllerUID);
 
@@ -31,35 +35,33 @@ Processor::Processor() {
 	initValue(ParamSpecs::resonatorOrder);
 }
 
-tresult PLUGIN_API Processor::setActive(TBool state) {
-	if (state) {
-		if (processSetup.symbolicSampleSize == kSample32) {
-			processorImpl = std::make_unique<ProcessorImpl<Math::PreComputedCubeResonator<float, maxDimension, maxOrder, 2>, float>>();
-		}
-		else {
-			processorImpl = std::make_unique<ProcessorImpl<Math::PreComputedCubeResonator<double, maxDimension, maxOrder, 2>, double>>();
-		}
-		processorImpl->init(processSetup.sampleRate);
-		recomputeParameters();
-	}
-	else {
-		processorImpl.reset();
-		sendMessageID(processorDeactivatedMsgID);
+std::unique_ptr<ProcessorImplBase> Processor::makeProcessorImpl(int32 symbolicSampleSize) const {
+	if (symbolicSampleSize == kSample32) {
+		return createProcessorImpl<ProcessorImpl, Resonator, float>(configuration);
 	}
-	return kResultTrue;
+	return createProcessorImpl<ProcessorImpl, Resonator, double>(configuration);
 }
 
-void Processor::recomputeInexpensiveParameters() {
-	resonatorOrder = toDiscrete(ParamSpecs::resonatorOrder);
-	ResonatorProcessorBase::recomputeInexpensiveParameters();
+void Processor::updateResonatorOrder() {
+	resonatorOrder = orderOf(paramState);
+	ResonatorProcessorBase::updateResonatorOrder();
 }
 
 void Processor::updateResonatorDimension() {
-	resonatorDim = toDiscrete(ParamSpecs::resonatorDim);
+	resonatorDim = dimensionOf(paramState);
 	ResonatorProcessorBase::updateResonatorDimension();
 }
 
+int Processor::dimensionOf(const ParamState& state) const {
+	return ParamSpecs::resonatorDim.toDiscrete(state[Params::kParamResonatorDim]);
+}
+
+int Processor::orderOf(const ParamState& state) const {
+	return ParamSpecs::resonatorOrder.toDiscrete(state[Params::kParamResonatorOrder]);
+}
+
 FUnknown* createProcessorInstance(void*) {
+	UBERTON_SCAN_TIMER("Tesseract processor construction");
 	return static_cast<IAudioProcessor*>(new Processor);
 }
 } // namespace Tesseract
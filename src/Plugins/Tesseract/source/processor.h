@@ -24,12 +24,13 @@ class Processor : public ResonatorProcessorBase
 public:
 	Processor();
 
-	tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
-
 
 private:
+	std::unique_ptr<ProcessorImplBase> makeProcessorImpl(int32 symbolicSampleSize) const override;
 	void updateResonatorDimension() override;
-	void recomputeInexpensiveParameters() override;
+	void updateResonatorOrder() override;
+	int dimensionOf(const ParamState& state) const override;
+	int orderOf(const ParamState& state) const override;
 };
 
 }
@@ -11,6 +11,7 @@
 
 #include "controller.h"
 #include <ui.h>
+#include <scan_timer.h>
 #include <subcontrollers.h>
 
 namespace Uberton {
@@ -156,6 +157,7 @@ void Controller::updateResonatorLength() {
 }
 
 FUnknown* createControllerInstance(void*) {
+	UBERTON_SCAN_TIMER("TesseractFx controller construction");
 	return static_cast<IEditController*>(new Controller);
 }
 
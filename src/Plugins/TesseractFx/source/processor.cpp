@@ -10,8 +10,6 @@
 
 
 #include "processor.h"
-#include <public.sdk/source/vst/vstaudioprocessoralgo.h>
-#include <chrono>
 
 namespace Uberton {
 namespace TesseractFx {
@@ -25,177 +23,45 @@ Processor::Processor() {
 
 	paramState.version = stateVersion;
 
-	initValue(ParamSpecs::vol);
-	initValue(ParamSpecs::mix);
-	initValue(ParamSpecs::resonatorType);
 	initValue(ParamSpecs::resonatorDim);
 	initValue(ParamSpecs::resonatorOrder);
-	initValue(ParamSpecs::resonatorFreq);
-	initValue(ParamSpecs::resonatorDamp);
-	initValue(ParamSpecs::resonatorVel);
-
-	initValue(ParamSpecs::inPosCurveL);
-	initValue(ParamSpecs::inPosCurveR);
-	initValue(ParamSpecs::outPosCurveL);
-	initValue(ParamSpecs::outPosCurveR);
-
-	initValue(ParamSpecs::lcFreq);
-	initValue(ParamSpecs::lcQ);
-	initValue(ParamSpecs::hcFreq);
-	initValue(ParamSpecs::hcQ);
-	initValue(ParamSpecs::limiterOn);
-
-	for (int i = 0; i < maxDimension; i++) {
-		paramState[Params::kParamInL0 + i] = .5;
-		paramState[Params::kParamInR0 + i] = .5;
-		paramState[Params::kParamOutL0 + i] = .5;
-		paramState[Params::kParamOutR0 + i] = .5;
-	}
-}
-
-tresult PLUGIN_API Processor::initialize(FUnknown* context) {
-	tresult result = ProcessorBase::initialize(context);
-	if (result != kResultTrue)
-		return kResultFalse;
-
-	addAudioInput(STR16("AudioInput"), SpeakerArr::kStereo);
-	addAudioOutput(STR16("AudioOutput"), SpeakerArr::kStereo);
-
-	return kResultTrue;
-}
-
-tresult PLUGIN_API Processor::setActive(TBool state) {
-	if (state) {
-		if (processSetup.symbolicSampleSize == kSample32) {
-			processorImpl = std::make_unique<ProcessorImpl<float>>();
-		}
-		else {
-			processorImpl = std::make_unique<ProcessorImpl<double>>();
-		}
-		processorImpl->init(processSetup.sampleRate);
-		recomputeParameters();
-	}
-	else {
-		processorImpl.reset();
-		sendMessageID(processorDeactivatedMsgID);
-	}
-	return kResultTrue;
 }
 
 tresult PLUGIN_API Processor::setBusArrangements(SpeakerArrangement* inputs, int32 numIns, SpeakerArrangement* outputs, int32 numOuts) {
 	// Only support stereo in/stereo out
 	if (numIns == 1 && numOuts == 1 && inputs[0] == SpeakerArr::kStereo && inputs[0] == outputs[0]) {
-		return ProcessorBase::setBusArrangements(inputs, numIns, outputs, numOuts);
+		return ResonatorProcessorBase::setBusArrangements(inputs, numIns, outputs, numOuts);
 	}
 	return kResultFalse;
 }
 
-tresult PLUGIN_API Processor::canProcessSampleSize(int32 symbolicSampleSize) {
-	if (symbolicSampleSize == kSample32) return kResultTrue;
-	if (symbolicSampleSize == kSample64) return kResultTrue;
-	return kResultFalse;
-}
-
-void Processor::processAudio(ProcessData& data) {
-	//using std::chrono::steady_clock;
-	//auto t0 = steady_clock::now();
-
-
-	// Handle silence flags
-	{
-		if (data.inputs[0].silenceFlags != 0 && vuPPM < 0.0001) {
-			data.outputs[0].silenceFlags = data.inputs[0].silenceFlags;
-
-			uint32 sampleFramesSize = getSampleFramesSizeInBytes(processSetup, data.numSamples);
-			int32 numChannels = data.inputs[0].numChannels;
-			void** in = getChannelBuffersPointer(processSetup, data.inputs[0]);
-			void** out = getChannelBuffersPointer(processSetup, data.outputs[0]);
-			for (int32 i = 0; i < numChannels; ++i) {
-				if (in[i] != out[i]) {
-					memset(out[i], 0, sampleFramesSize);
-				}
-			}
-			return;
-		}
-		data.outputs[0].silenceFlags = 0;
+std::unique_ptr<ResonatorPlugin::ProcessorImplBase> Processor::makeProcessorImpl(int32 symbolicSampleSize) const {
+	if (symbolicSampleSize == kSample32) {
+		return std::make_unique<ProcessorImpl<float>>();
 	}
-
-	vuPPM = processorImpl->processAll(data, mix, volume, limiterOn);
-
-	//std::chrono::duration<double> duration = steady_clock::now() - t0;
-	//addOutputPoint(data, kParamProcessTime, (duration.count() / data.numSamples) * 1000.0 / 10.0);
+	return std::make_unique<ProcessorImpl<double>>();
 }
 
-void Processor::processParameterChanges(IParameterChanges* inputParameterChanges) {
-	Algo::foreach (inputParameterChanges, [&](IParamValueQueue& paramQueue) {
-		// Just process the latest parameter change and apply it immediately (ignoring sampleOffset)
-		// For sample-accurate automation this needs to be more precise.
-		Algo::foreachLast(paramQueue, [&](int32 id, int32 sampleOffset, ParamValue value) {
-			if (id == bypassId) {
-				setBypassed(value > 0.5);
-			}
-			else {
-				paramState.params[id] = value;
-			}
-			if (id == Params::kParamInPosCurveL || id == Params::kParamInPosCurveR || (id >= Params::kParamInL0 && id <= Params::kParamInRN)) {
-				processorImpl->updateResonatorInputPosition(paramState);
-			}
-			if (id == Params::kParamOutPosCurveL || id == Params::kParamOutPosCurveR || (id >= Params::kParamOutL0 && id <= Params::kParamOutRN)) {
-				processorImpl->updateResonatorOutputPosition(paramState);
-			}
-			if (id == Params::kParamResonatorDim) {
-				updateResonatorDimension();
-			}
-		}
-
-		);
-	});
-	recomputeInexpensiveParameters();
+void Processor::updateResonatorOrder() {
+	resonatorOrder = orderOf(paramState);
+	ResonatorProcessorBase::updateResonatorOrder();
 }
 
-void Processor::beforeBypass(ProcessData& data) {
-	// add "last" data point, before processAudio() is not called anymore
-	Processor::addOutputPoint(data, kParamVUPPM_L, 0);
-	Processor::addOutputPoint(data, kParamVUPPM_R, 0);
+void Processor::updateResonatorDimension() {
+	resonatorDim = dimensionOf(paramState);
+	ResonatorProcessorBase::updateResonatorDimension();
 }
 
-void Processor::recomputeParameters() {
-	recomputeInexpensiveParameters();
-	updateResonatorDimension(); // also updates positions!
+int Processor::dimensionOf(const ResonatorPlugin::ParamState& state) const {
+	return ParamSpecs::resonatorDim.toDiscrete(state[Params::kParamResonatorDim]);
 }
 
-void Processor::recomputeInexpensiveParameters() {
-	volume = toScaled(ParamSpecs::vol);
-	mix = paramState[Params::kParamMix];
-	resonatorOrder = toDiscrete(ParamSpecs::resonatorOrder);
-	resonatorFreq = toScaled(ParamSpecs::resonatorFreq);
-	resonatorDamp = toScaled(ParamSpecs::resonatorDamp);
-	resonatorVel = toScaled(ParamSpecs::resonatorVel);
-	limiterOn = paramState[Params::kParamLimiterOn] != 0;
-
-	// auto& f = processorImpl->resonator.timeFunctions;
-	// FDebugPrint("Out EF %i %i: %f, %f, %f, %f,%f, %f, %f, %f, %f, %f\n", resonatorDim, resonatorOrder, f[0].real(), f[1].real(), f[2].real(), f[3].real(), f[4].real(), f[5].real(), f[6].real(), f[7].real(), f[8].real(), f[9].real());
-
-	if (processorImpl) {
-		processorImpl->setResonatorFreq(resonatorFreq, resonatorDamp, resonatorVel);
-		processorImpl->setResonatorOrder(resonatorOrder);
-		processorImpl->setLCFilterFreqAndQ(toScaled(ParamSpecs::lcFreq), toScaled(ParamSpecs::lcQ));
-		processorImpl->setHCFilterFreqAndQ(toScaled(ParamSpecs::hcFreq), toScaled(ParamSpecs::hcQ));
-	}
+int Processor::orderOf(const ResonatorPlugin::ParamState& state) const {
+	return ParamSpecs::resonatorOrder.toDiscrete(state[Params::kParamResonatorOrder]);
 }
 
-void Processor::updateResonatorDimension() {
-	resonatorDim = toDiscrete(ParamSpecs::resonatorDim);
-	if (processorImpl) {
-		processorImpl->setResonatorDim(resonatorDim);
-		// Need to reevaluate all eigenfunctions
-		processorImpl->updateResonatorInputPosition(paramState);
-		processorImpl->updateResonatorOutputPosition(paramState);
-	}
-	//auto& f = processorImpl->resonator.inputPosEF[0];
-	//FDebugPrint("Out EF %i: %f, %f, %f, %f,%f, %f, %f, %f, %f, %f\n", resonatorDim, f[0].real(), f[1].real(), f[2].real(), f[3].real(), f[4].real(), f[5].real(), f[6].real(), f[7].real(), f[8].real(), f[9].real());
-}
 FUnknown* createProcessorInstance(void*) {
+	UBERTON_SCAN_TIMER("TesseractFx processor construction");
 	return static_cast<IAudioProcessor*>(new Processor);
 }
 } // namespace TesseractFx
@@ -11,54 +11,35 @@
 
 #pragma once
 
-#include <ProcessorBase.h>
+#include <ResonatorProcessor.h>
 #include "ids.h"
-#include "processorImpl.h"
 
 namespace Uberton {
 namespace TesseractFx {
 
+// TesseractFx is the stereo version of the resonator plugins. Its parameters are the leading
+// parameters of the common ones, the processor state has the others appended.
+static_assert(maxDimension == ResonatorPlugin::maxDimension);
+static_assert(static_cast<ParamID>(Params::kParamLimiterOn) == ResonatorPlugin::Params::kParamLimiterOn, "the parameter ids need to match the common ones");
 
-class Processor : public ProcessorBase<ParamState, ImplementBypass>
+template<typename SampleType>
+using ProcessorImpl = ResonatorPlugin::ProcessorImpl<Math::PreComputedCubeResonator<SampleType, maxDimension, maxOrder, 2, 2>, SampleType>;
+
+class Processor : public ResonatorPlugin::ResonatorProcessorBase
 {
 public:
 	Processor();
 
-	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE;
-	tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
 	tresult PLUGIN_API setBusArrangements(SpeakerArrangement* inputs, int32 numIns, SpeakerArrangement* outputs, int32 numOuts) SMTG_OVERRIDE;
-	tresult PLUGIN_API canProcessSampleSize(int32 symbolicSampleSize) SMTG_OVERRIDE;
-
-	void processAudio(ProcessData& data) override;
-	void processParameterChanges(IParameterChanges* parameterChanges) override;
-	void beforeBypass(ProcessData& data) override;
 
 
 private:
-	// Inexpensive parameter udpates
-	void recomputeInexpensiveParameters();
-
-	// Expensive parameter udpates
-	void updateResonatorDimension();
-
-	// Update all parameters (expensive and inexpensive)
-	void recomputeParameters() override;
-
-
-
-	std::unique_ptr<ProcessorImplBase> processorImpl;
-
-	float volume{ 0 };
-	float mix{ 1 };
-	int resonatorDim = maxDimension;
-	int resonatorOrder = maxOrder;
-	float resonatorFreq{ 0 };
-	float resonatorDamp{ 0 };
-	float resonatorVel{ 0 };
-	bool limiterOn{ false };
-
-	double vuPPM = 0; // contains max of left and right channel from last buffer to check if there is silence
+	std::unique_ptr<ResonatorPlugin::ProcessorImplBase> makeProcessorImpl(int32 symbolicSampleSize) const override;
+	void updateResonatorDimension() override;
+	void updateResonatorOrder() override;
+	int dimensionOf(const ResonatorPlugin::ParamState& state) const override;
+	int orderOf(const ResonatorPlugin::ParamState& state) const override;
 };
 
 }
-}
\ No newline at end of file
+}
@@ -18,6 +18,7 @@ namespace Uberton {
 ProcessorBaseA::ProcessorBaseA() {}
 
 tresult PLUGIN_API ProcessorBaseA::process(ProcessData& data) {
+	UBERTON_RT_AUDIT_SCOPE;
 	processParameterChanges(data.inputParameterChanges);
 	processEvents(data.inputEvents);
 
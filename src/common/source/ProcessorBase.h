@@ -19,6 +19,9 @@
 #include <public.sdk/source/vst/vstaudioprocessoralgo.h>
 #include <public.sdk/source/vst/utility/rttransfer.h>
 #include "parameters.h"
+#include "lockfree.h"
+#include "scan_timer.h"
+#include "rt_audit.h"
 
 
 namespace Uberton {
@@ -82,6 +85,7 @@ template<class ParamState, bool hasBypass = ImplementBypass>
 //	{ p[i] } -> std::convertible_to<double>;
 //	{ p.isBypassed() } -> std::convertible_to<bool>;
 //	p.setBypass(b);
+//	p.takeChanges(p);
 // }
 class ProcessorBase;
 
@@ -94,25 +98,41 @@ template<class ParamState>
 class ProcessorBaseCommon : public AudioEffect
 {
 public:
+	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE {
+		// the derived constructors have set the default values by now
+		defaultState = paramState;
+		return AudioEffect::initialize(context);
+	}
+
 	tresult PLUGIN_API getState(IBStream* state) SMTG_OVERRIDE {
+		UBERTON_SCAN_TIMER("ProcessorBase::getState");
 		if (!state) return kInvalidArgument;
 		return paramState.getState(state);
 	}
 
 	tresult PLUGIN_API setState(IBStream* state) SMTG_OVERRIDE {
+		UBERTON_SCAN_TIMER("ProcessorBase::setState");
 		if (!state) return kInvalidArgument;
-		auto paramChanges = std::make_unique<ParamState>();
+		// recycled from the pool, parameters that are missing in the stream keep their defaults
+		auto paramChanges = statePool.acquire();
+		*paramChanges = defaultState;
 		tresult result = paramChanges->setState(state);
+		prepareState(*paramChanges);
 		this->stateTransfer.transferObject_ui(std::move(paramChanges));
 		return result;
 	}
 
+	// called in setState() before the new state is transferred to the audio thread, the place
+	// for expensive precomputations that the audio thread would otherwise do for this state
+	virtual void prepareState(const ParamState& state) {}
+
 	virtual void processAudio(ProcessData& data) = 0;
 	virtual void processParameterChanges(IParameterChanges* parameterChanges) = 0;
 	virtual void processEvents(IEventList* eventList) {}
 	virtual void beforeBypass(ProcessData& data){}; // called during process() when bypass has been activated, before the off ramp is started
 
-	void checkSilence(ProcessData& data) {
+	// called after processAudio(), can be overridden by processors that set the silence flags while processing
+	virtual void checkSilence(ProcessData& data) {
 		for (int32 i = 0; i < data.numOutputs; i++) {
 			auto& bus = data.outputs[i];
 			bus.silenceFlags = 0;
@@ -156,7 +176,12 @@ public:
 
 protected:
 	ParamState paramState;
-	using RTTransfer = RTTransferT<ParamState>;
+	ParamState defaultState;
+	// Transferred states go back to the pool instead of being deleted. RTTransferT holds at
+	// most two of them, the pool is destroyed after the transfer.
+	using StatePool = ObjectPool<ParamState, 4>;
+	StatePool statePool;
+	using RTTransfer = RTTransferT<ParamState, typename StatePool::Releaser>;
 	RTTransfer stateTransfer;
 };
 
@@ -178,8 +203,9 @@ class ProcessorBase<ParamState, ImplementBypass> : public ProcessorBaseCommon<Pa
 {
 public:
 	tresult PLUGIN_API process(ProcessData& data) SMTG_OVERRIDE {
+		UBERTON_RT_AUDIT_SCOPE;
 		this->stateTransfer.accessTransferObject_rt([this](const ParamState& stateChanges) {
-			this->paramState = stateChanges;
+			this->paramState.takeChanges(stateChanges); // marks the changed parameters as dirty
 		});
 		this->processParameterChanges(data.inputParameterChanges);
 		this->processEvents(data.inputEvents);
@@ -206,8 +232,13 @@ public:
 			float wet = 0;
 			float f = 1.0f / data.numSamples;
 
-			for (int channel = 0; channel < data.numInputs; channel++) {
-				Sample32* in = data.inputs[0].channelBuffers32[channel];
+			// a mono input is ramped into all output channels, additional output channels
+			// (i.e. surround channels for a stereo input) are ramped from/to silence, as are
+			// all channels of an instrument without input bus
+			const int32 numInputChannels = data.numInputs > 0 ? data.inputs[0].numChannels : 0;
+			for (int channel = 0; channel < data.outputs[0].numChannels; channel++) {
+				const int32 inChannel = numInputChannels == 1 ? 0 : channel;
+				Sample32* in = inChannel < numInputChannels ? data.inputs[0].channelBuffers32[inChannel] : nullptr;
 				Sample32* out = data.outputs[0].channelBuffers32[channel];
 				if (in == out) continue;
 
@@ -215,14 +246,14 @@ public:
 					for (int i = 0; i < data.numSamples; i++) {
 						dry = i * f;
 						wet = (data.numSamples - i) * f;
-						out[i] = wet * out[i] + dry * in[i];
+						out[i] = wet * out[i] + (in ? dry * in[i] : 0);
 					}
 				}
 				else { // bypassingState == BypassingState::RampToOn
 					for (int i = 0; i < data.numSamples; i++) {
 						dry = (data.numSamples - i) * f;
 						wet = i * f;
-						out[i] = wet * out[i] + dry * in[i];
+						out[i] = wet * out[i] + (in ? dry * in[i] : 0);
 					}
 				}
 			}
@@ -231,10 +262,25 @@ public:
 			return true;
 		}
 		else if (isBypassed()) {
+			if (data.numInputs == 0) {
+				// Bypassed instrument: silence
+				for (int32 bus = 0; bus < data.numOutputs; bus++) {
+					Algo::clear32(&data.outputs[bus], data.numSamples);
+				}
+				return true;
+			}
 			// Bypass (first in/out bus pair is copied, all other output busses are cleared)
 			AudioBusBuffers& inBus = data.inputs[0];
 			AudioBusBuffers& outBus = data.outputs[0];
 			Algo::copy32(&inBus, &outBus, data.numSamples, 0);
+			// mono input: copy to the remaining output channels, otherwise clear them
+			for (int32 channel = inBus.numChannels; channel < outBus.numChannels; channel++) {
+				Sample32* out = outBus.channelBuffers32[channel];
+				if (inBus.numChannels == 1)
+					std::copy(inBus.channelBuffers32[0], inBus.channelBuffers32[0] + data.numSamples, out);
+				else
+					std::fill(out, out + data.numSamples, 0.f);
+			}
 
 			for (int32 bus = 1; bus < data.numOutputs; bus++) {
 				Algo::clear32(&data.outputs[bus], data.numSamples);
@@ -278,8 +324,9 @@ class ProcessorBase<ParamState, NoBypass> : public ProcessorBaseCommon<ParamStat
 {
 public:
 	tresult PLUGIN_API process(ProcessData& data) SMTG_OVERRIDE {
+		UBERTON_RT_AUDIT_SCOPE;
 		this->stateTransfer.accessTransferObject_rt([this](const ParamState& stateChanges) {
-			this->paramState = stateChanges;
+			this->paramState.takeChanges(stateChanges); // marks the changed parameters as dirty
 		});
 		this->processParameterChanges(data.inputParameterChanges);
 		this->processEvents(data.inputEvents);
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <algorithm>
+
 // ADSR evenlope with quadratic attack, decay and release curves:
 //     .
 //    /|
@@ -51,20 +53,37 @@ public:
 		if (constant) return value;
 		value += c0 * (a0 - index - 1);
 		if (++index == nextBreak) {
-			if (nextBreak == attackEnd) { // finished attack period
-				c0 = cd;
-				a0 = decayEnd;
-				nextBreak = decayEnd;
-			} else if (nextBreak == decayEnd) { // finished decay period
-				constant = true;
-			} else if (nextBreak == releaseEnd) { // finished release period
-				value = 0;
-				constant = true;
-			}
+			nextPeriod();
 		}
 		return value;
 	}
 
+	// Same as calling next() numSamples times. Each period is filled in closed form: after j
+	// steps from index, the value has grown by c0·j·(m - (j-1)/2) with m = a0 - index - 1 (the sum
+	// of the per sample increments). The periods are only switched at the breakpoints.
+	void render(float* out, int numSamples) noexcept {
+		int i = 0;
+		while (i < numSamples) {
+			if (constant) {
+				std::fill(out + i, out + numSamples, static_cast<float>(value));
+				return;
+			}
+			const int count = samplesInPeriod(numSamples - i);
+			const double m = a0 - index - 1;
+			for (int k = 0; k < count; k++) {
+				const double j = k + 1;
+				out[i + k] = static_cast<float>(value + c0 * j * (m - 0.5 * (j - 1)));
+			}
+			value += c0 * count * (m - 0.5 * (count - 1));
+			index += count;
+			i += count;
+			if (index == nextBreak) {
+				nextPeriod();
+				out[i - 1] = static_cast<float>(value); // the release ends at exactly 0
+			}
+		}
+	}
+
 
 	bool hasReachedSustain() const {
 		return index == decayEnd;
@@ -76,6 +95,24 @@ public:
 
 
 private:
+	void nextPeriod() noexcept {
+		if (nextBreak == attackEnd) { // finished attack period
+			c0 = cd;
+			a0 = decayEnd;
+			nextBreak = decayEnd;
+		} else if (nextBreak == decayEnd) { // finished decay period
+			constant = true;
+		} else if (nextBreak == releaseEnd) { // finished release period
+			value = 0;
+			constant = true;
+		}
+	}
+
+	// number of samples until the next breakpoint (at most maxSamples)
+	int samplesInPeriod(int maxSamples) const noexcept {
+		return nextBreak > index ? std::min(maxSamples, nextBreak - index) : maxSamples;
+	}
+
 	int attackEnd{ 1 };
 	int decayEnd{ 1 };
 	int releaseEnd{ 1 };
@@ -154,20 +191,34 @@ public:
 		if (constant) return value;
 		value += currentRamp;
 		if (++index == nextBreak) {
-			if (nextBreak == attackEnd) {
-				currentRamp = (s - 1.) / d;
-				decayEnd = attackEnd + d;
-				nextBreak = decayEnd;
-			} else if (nextBreak == decayEnd) {
-				constant = true;
-			} else if (nextBreak == releaseEnd) {
-				value = 0;
-				constant = true;
-			}
+			nextPeriod();
 		}
 		return value;
 	}
 
+	// Same as calling next() numSamples times, each period is filled as a ramp
+	// value + j·currentRamp and the periods are only switched at the breakpoints.
+	void render(float* out, int numSamples) noexcept {
+		int i = 0;
+		while (i < numSamples) {
+			if (constant) {
+				std::fill(out + i, out + numSamples, static_cast<float>(value));
+				return;
+			}
+			const int count = samplesInPeriod(numSamples - i);
+			for (int k = 0; k < count; k++) {
+				out[i + k] = static_cast<float>(value + (k + 1) * currentRamp);
+			}
+			value += count * currentRamp;
+			index += count;
+			i += count;
+			if (index == nextBreak) {
+				nextPeriod();
+				out[i - 1] = static_cast<float>(value); // the release ends at exactly 0
+			}
+		}
+	}
+
 	bool hasReachedSustain() const {
 		return index == decayEnd;
 	}
@@ -178,6 +229,23 @@ public:
 
 
 private:
+	void nextPeriod() noexcept {
+		if (nextBreak == attackEnd) {
+			currentRamp = (s - 1.) / d;
+			decayEnd = attackEnd + d;
+			nextBreak = decayEnd;
+		} else if (nextBreak == decayEnd) {
+			constant = true;
+		} else if (nextBreak == releaseEnd) {
+			value = 0;
+			constant = true;
+		}
+	}
+
+	int samplesInPeriod(int maxSamples) const noexcept {
+		return nextBreak > index ? std::min(maxSamples, nextBreak - index) : maxSamples;
+	}
+
 	double currentRamp;
 
 	int a, d, r;
@@ -194,4 +262,5 @@ private:
 	double value{ 0 }; // current velocity
 
 	double releaseValue{ 0 }; // value at time of release
-};
\ No newline at end of file
+};
+
@@ -0,0 +1,208 @@
+// Stereo biquad cascade with two stages (e.g. low cut + high cut)
+//  - transposed direct form II
+//  - both channels and both stages share one SIMD register
+//  - coefficient smoothing for click-free frequency / Q automation
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Uberton {
+
+//
+// The four filters (left/right × stage 1/2) run side by side in the lanes
+// [L₁, R₁, L₂, R₂]. Because stage 2 needs the output of stage 1, the stages are pipelined:
+// in each step stage 2 filters what stage 1 produced in the previous step. This adds a latency
+// of one sample to the cascade but lets all four filters run in a single vector operation
+// (one register for float, two for double with SSE2/NEON).
+//
+// Each stage is a lowpass or highpass biquad after the RBJ audio EQ cookbook. New frequencies
+// and Q values glide exponentially (time constant smoothingTime) from the current coefficients
+// to the target ones, so parameter automation does not click.
+//
+// Usage:
+//   StereoBiquadCascade<float> filter{ Type::Highpass, Type::Lowpass };
+//   filter.setSampleRate(44100);
+//   filter.setFreqAndQ(0, 200, 1);
+//   filter.processBlock(left, right, numSamples); // in place, right may be nullptr for mono
+//
+template<class T>
+class StereoBiquadCascade
+{
+public:
+	enum class Type {
+		Lowpass,
+		Highpass
+	};
+
+	static constexpr int numStages = 2;
+	static constexpr int numLanes = 4;
+	static constexpr double smoothingTime = 0.01; // seconds
+
+	StereoBiquadCascade(Type first = Type::Highpass, Type second = Type::Lowpass) : types{ first, second } {
+		for (int stage = 0; stage < numStages; stage++) {
+			setStageCoefficients(current, stage, identity());
+			setStageCoefficients(target, stage, identity());
+		}
+	}
+
+	void setSampleRate(double newSampleRate) {
+		sampleRate = newSampleRate;
+		smoothingFactor = static_cast<T>(1 - std::exp(-1 / (smoothingTime * sampleRate)));
+		for (int stage = 0; stage < numStages; stage++) {
+			if (initialized[stage]) {
+				setStageCoefficients(target, stage, computeCoefficients(types[stage], freqs[stage], qs[stage]));
+			}
+		}
+		current = target;
+		smoothingRemaining = 0;
+	}
+
+	// Set new target frequency and Q for the given stage. The first call per stage jumps to the
+	// target directly.
+	void setFreqAndQ(int stage, double freq, double q) {
+		freqs[stage] = freq;
+		qs[stage] = q;
+		const Coefficients c = computeCoefficients(types[stage], freq, q);
+		setStageCoefficients(target, stage, c);
+		if (!initialized[stage]) {
+			initialized[stage] = true;
+			setStageCoefficients(current, stage, c);
+			return;
+		}
+		smoothingRemaining = static_cast<int>(8 * smoothingTime * sampleRate); // e⁻⁸ < 0.1%
+	}
+
+	void reset() {
+		state1.fill(Vec(T(0)));
+		state2.fill(Vec(T(0)));
+		pipeline[0] = pipeline[1] = 0;
+	}
+
+	/// Filter a stereo pair of samples in place
+	void processSample(T& left, T& right) {
+		T lanes[numLanes] = { left, right, pipeline[0], pipeline[1] };
+		step(lanes);
+		if (smoothingRemaining > 0 && --smoothingRemaining == 0) {
+			current = target;
+		}
+		pipeline[0] = lanes[0];
+		pipeline[1] = lanes[1];
+		left = lanes[2];
+		right = lanes[3];
+	}
+
+	/// Filter a block in place. right may be nullptr (mono) or equal to left.
+	void processBlock(T* left, T* right, int numSamples) {
+		T dummy = 0;
+		for (int i = 0; i < numSamples; i++) {
+			processSample(left[i], right && right != left ? right[i] : dummy);
+		}
+	}
+
+private:
+	using Vec = Simd::Vec<T>;
+	static constexpr int numRegisters = numLanes / Vec::size;
+
+	struct Coefficients
+	{
+		T b0, b1, b2, a1, a2;
+	};
+	struct LaneCoefficients
+	{
+		std::array<Vec, numRegisters> b0, b1, b2, a1, a2;
+	};
+
+	static Coefficients identity() { return { 1, 0, 0, 0, 0 }; }
+
+	Coefficients computeCoefficients(Type type, double freq, double q) const {
+		constexpr double pi = 3.14159265358979323846;
+		freq = std::min(std::max(freq, 10.0), 0.45 * sampleRate);
+		q = std::max(q, 0.1);
+		const double omega = 2 * pi * freq / sampleRate;
+		const double cosOmega = std::cos(omega);
+		const double alpha = std::sin(omega) / (2 * q);
+		const double a0 = 1 + alpha;
+		const double b1 = type == Type::Lowpass ? 1 - cosOmega : -(1 + cosOmega);
+		const double b0 = 0.5 * std::abs(b1);
+		return {
+			static_cast<T>(b0 / a0),
+			static_cast<T>(b1 / a0),
+			static_cast<T>(b0 / a0),
+			static_cast<T>(-2 * cosOmega / a0),
+			static_cast<T>((1 - alpha) / a0)
+		};
+	}
+
+	// stage s occupies the lanes 2s and 2s + 1
+	static void setStageCoefficients(LaneCoefficients& lanes, int stage, const Coefficients& c) {
+		auto set = [stage](std::array<Vec, numRegisters>& regs, T value) {
+			T values[numLanes];
+			for (int r = 0; r < numRegisters; r++) {
+				regs[r].store(values + r * Vec::size);
+			}
+			values[2 * stage] = values[2 * stage + 1] = value;
+			for (int r = 0; r < numRegisters; r++) {
+				regs[r] = Vec::load(values + r * Vec::size);
+			}
+		};
+		set(lanes.b0, c.b0);
+		set(lanes.b1, c.b1);
+		set(lanes.b2, c.b2);
+		set(lanes.a1, c.a1);
+		set(lanes.a2, c.a2);
+	}
+
+	// One TDF-II step on all lanes: y = b0·x + s1;  s1 = b1·x - a1·y + s2;  s2 = b2·x - a2·y
+	void step(T* lanes) {
+		const bool smoothing = smoothingRemaining > 0;
+		const Vec k(smoothingFactor);
+		for (int r = 0; r < numRegisters; r++) {
+			if (smoothing) {
+				glide(current.b0[r], target.b0[r], k);
+				glide(current.b1[r], target.b1[r], k);
+				glide(current.b2[r], target.b2[r], k);
+				glide(current.a1[r], target.a1[r], k);
+				glide(current.a2[r], target.a2[r], k);
+			}
+			const Vec x = Vec::load(lanes + r * Vec::size);
+			const Vec y = current.b0[r] * x + state1[r];
+			state1[r] = current.b1[r] * x - current.a1[r] * y + state2[r];
+			state2[r] = current.b2[r] * x - current.a2[r] * y;
+			y.store(lanes + r * Vec::size);
+		}
+	}
+
+	static void glide(Vec& value, Vec target, Vec k) { value = value + k * (target - value); }
+
+	std::array<Type, numStages> types;
+	std::array<double, numStages> freqs{};
+	std::array<double, numStages> qs{};
+	std::array<bool, numStages> initialized{};
+
+	LaneCoefficients current{};
+	LaneCoefficients target{};
+	std::array<Vec, numRegisters> state1{};
+	std::array<Vec, numRegisters> state2{};
+	T pipeline[2]{}; // stage 1 output of the previous step
+
+	double sampleRate{ 44100 };
+	T smoothingFactor{ 1 };
+	int smoothingRemaining{ 0 };
+};
+
+} // namespace Uberton
@@ -0,0 +1,196 @@
+// Lookahead brickwall limiter
+//  - O(1) sliding window peak detection with a monotonic deque
+//  - inter-sample (true) peak estimation
+//  - block based gain computation and application
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Uberton {
+
+//
+// Monotonic deque for the maximum over the last windowSize pushed values. Amortized O(1) per push.
+//
+template<class T>
+class SlidingMaximum
+{
+public:
+	void setWindowSize(int size) {
+		windowSize = size;
+		entries.assign(size + 1, {});
+		reset();
+	}
+
+	void reset() {
+		head = tail = 0;
+		count = 0;
+		time = 0;
+	}
+
+	// push a new value and return the maximum of the last windowSize values
+	T push(T value) {
+		const int capacity = static_cast<int>(entries.size());
+		// values that are smaller than the new one can never become the maximum again
+		while (count > 0 && entries[back()].value <= value) {
+			tail = back();
+			count--;
+		}
+		entries[tail] = { time, value };
+		tail = (tail + 1) % capacity;
+		count++;
+		// drop the front if it has left the window
+		if (entries[head].time + windowSize <= time) {
+			head = (head + 1) % capacity;
+			count--;
+		}
+		time++;
+		return entries[head].value;
+	}
+
+private:
+	struct Entry
+	{
+		int64_t time;
+		T value;
+	};
+
+	int back() const { return (tail + static_cast<int>(entries.size()) - 1) % static_cast<int>(entries.size()); }
+
+	std::vector<Entry> entries;
+	int windowSize{ 1 };
+	int head{ 0 }, tail{ 0 }, count{ 0 };
+	int64_t time{ 0 };
+};
+
+
+//
+// The gain that keeps the (estimated true) peak at the ceiling is held for the lookahead time with
+// a sliding maximum of the peaks, then smoothed with a moving average over the lookahead time.
+// The held gain is at its minimum for the entire averaging window of a peak, so the averaged gain
+// reaches the required value exactly when the peak leaves the delay line (brickwall). Rising gain
+// is additionally smoothed with a release time.
+//
+// Inter-sample peaks are estimated with the cubic interpolated midpoint between two samples.
+//
+// The audio is delayed by latencySamples(). Blocks need to be at most maxBlockSize long.
+//
+// Usage:
+//   limiter.setSampleRate(sampleRate); // allocates, not real-time safe
+//   limiter.process(in, numChannels, numSamples);
+//   out[ch][i] = limiter.delayed(ch)[i] * limiter.gains()[i];
+//
+template<class T, int maxChannels, int maxBlockSize>
+class LookaheadLimiter
+{
+public:
+	static constexpr double lookaheadTime = 0.002; // seconds
+	static constexpr double releaseTime = 0.05;	   // seconds
+	static constexpr double ceilingDB = -0.3;
+
+	void setSampleRate(double sampleRate) {
+		// at least 2 so the midpoint estimate can look 3 samples back into the delay line
+		lookahead = std::max(2, static_cast<int>(std::lround(lookaheadTime * sampleRate)));
+		// the midpoint estimate lags the newest sample by up to 2 samples
+		delay = lookahead + 1;
+		peaks.setWindowSize(lookahead + 2);
+		average.assign(lookahead, 1);
+		for (auto& channel : buffers) {
+			channel.assign(delay + maxBlockSize, 0);
+		}
+		releaseFactor = 1 - std::exp(-1 / (releaseTime * sampleRate));
+		reset();
+	}
+
+	void reset() {
+		peaks.reset();
+		std::fill(average.begin(), average.end(), 1);
+		averageSum = lookahead;
+		averageIndex = 0;
+		heldGain = 1;
+		for (auto& channel : buffers) {
+			std::fill(channel.begin(), channel.end(), 0);
+		}
+	}
+
+	int latencySamples() const { return delay; }
+
+	// Feed a block (numSamples ≤ maxBlockSize) and compute gains() and delayed() for it
+	void process(const T* const* in, int numChannels, int numSamples) {
+		assert(numSamples <= maxBlockSize && numChannels <= maxChannels);
+		for (int ch = 0; ch < numChannels; ch++) {
+			std::copy(in[ch], in[ch] + numSamples, buffers[ch].begin() + delay);
+		}
+
+		for (int i = 0; i < numSamples; i++) {
+			T peak = 0;
+			for (int ch = 0; ch < numChannels; ch++) {
+				const T* x = buffers[ch].data() + delay + i;
+				const T midpoint = (T(9) * (x[-2] + x[-1]) - (x[-3] + x[0])) * T(0.0625);
+				peak = std::max({ peak, std::abs(x[0]), std::abs(midpoint) });
+			}
+			const double maxPeak = peaks.push(peak);
+			const double gain = maxPeak > ceiling ? ceiling / maxPeak : 1.0;
+
+			heldGain = gain < heldGain ? gain : heldGain + releaseFactor * (gain - heldGain);
+
+			averageSum += heldGain - average[averageIndex];
+			average[averageIndex] = heldGain;
+			averageIndex = averageIndex + 1 == lookahead ? 0 : averageIndex + 1;
+			gainBuffer[i] = static_cast<T>(std::min(averageSum / lookahead, 1.0));
+		}
+
+		numDelayed = numSamples;
+		activeChannels = numChannels;
+	}
+
+	// The gains for the last processed block
+	const T* gains() const { return gainBuffer.data(); }
+
+	// The input delayed by latencySamples() for the last processed block
+	const T* delayed(int ch) const { return buffers[ch].data(); }
+
+	// Needs to be called after the delayed samples of a block have been consumed
+	void advance() {
+		for (int ch = 0; ch < activeChannels; ch++) {
+			auto& b = buffers[ch];
+			std::copy(b.begin() + numDelayed, b.begin() + numDelayed + delay, b.begin());
+		}
+		numDelayed = 0;
+	}
+
+private:
+	const double ceiling = std::pow(10.0, ceilingDB / 20);
+
+	int lookahead{ 2 };
+	int delay{ 3 };
+	SlidingMaximum<double> peaks;
+	std::vector<double> average;
+	double averageSum{ 2 };
+	int averageIndex{ 0 };
+	double heldGain{ 1 };
+	double releaseFactor{ 1 };
+
+	std::array<std::vector<T>, maxChannels> buffers; // delay history followed by the current block
+	std::array<T, maxBlockSize> gainBuffer{};
+	int numDelayed{ 0 };
+	int activeChannels{ 0 };
+};
+
+} // namespace Uberton
@@ -0,0 +1,82 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include "lockfree.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+namespace Uberton {
+
+#ifdef _WIN32
+
+Semaphore::Semaphore() : handle(CreateSemaphoreW(nullptr, 0, MAXLONG, nullptr)) {}
+
+Semaphore::~Semaphore() {
+	CloseHandle(handle);
+}
+
+void Semaphore::post() {
+	ReleaseSemaphore(handle, 1, nullptr);
+}
+
+void Semaphore::wait() {
+	WaitForSingleObject(handle, INFINITE);
+}
+
+#elif __APPLE__
+
+// unnamed POSIX semaphores are not supported on macOS
+Semaphore::Semaphore() : handle(dispatch_semaphore_create(0)) {}
+
+Semaphore::~Semaphore() {
+	dispatch_release(static_cast<dispatch_semaphore_t>(handle));
+}
+
+void Semaphore::post() {
+	dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(handle));
+}
+
+void Semaphore::wait() {
+	dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(handle), DISPATCH_TIME_FOREVER);
+}
+
+#else
+
+Semaphore::Semaphore() : handle(new sem_t) {
+	sem_init(static_cast<sem_t*>(handle), 0, 0);
+}
+
+Semaphore::~Semaphore() {
+	sem_destroy(static_cast<sem_t*>(handle));
+	delete static_cast<sem_t*>(handle);
+}
+
+void Semaphore::post() {
+	sem_post(static_cast<sem_t*>(handle));
+}
+
+void Semaphore::wait() {
+	while (sem_wait(static_cast<sem_t*>(handle)) != 0 && errno == EINTR) {}
+}
+
+#endif
+
+} // namespace Uberton
@@ -0,0 +1,180 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Uberton {
+
+//
+// Wait-free single producer / single consumer triple buffer.
+//
+// The writer always owns one buffer it can fill at leisure and publishes it by swapping
+// it with the shared "middle" buffer. The reader swaps the middle buffer with its own one
+// when something new has been published. Neither side ever blocks and the reader always
+// gets the most recently published value (intermediate values may be skipped).
+//
+// Usage:
+//   writer:  buffer.writeBuffer() = value; buffer.publish();
+//   reader:  if (buffer.update()) use(buffer.readBuffer());
+//
+template<class T>
+class TripleBuffer
+{
+public:
+	// Writer side
+	T& writeBuffer() noexcept { return buffers[writeIndex]; }
+
+	void publish() noexcept {
+		writeIndex = middle.exchange(writeIndex | dirtyBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// Reader side: returns true if a new value has been published since the last call
+	bool update() noexcept {
+		if ((middle.load(std::memory_order_relaxed) & dirtyBit) == 0) return false;
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+	const T& readBuffer() const noexcept { return buffers[readIndex]; }
+
+private:
+	static constexpr int dirtyBit = 4;
+	static constexpr int indexMask = 3;
+
+	std::array<T, 3> buffers{};
+	std::atomic<int> middle{ 1 };
+	int writeIndex{ 0 };
+	int readIndex{ 2 };
+};
+
+
+//
+// Lock-free fixed size pool of preallocated objects.
+//
+// acquire() hands out an object as a unique_ptr whose deleter puts it back into the pool, so it
+// can be passed on like a heap allocated object (i.e. through RTTransferT with Releaser as the
+// deleter). Objects are recycled as they are, the previous contents need to be overwritten.
+// The free objects are kept in a Treiber stack of indices, the head carries a tag that is
+// incremented with every change against the ABA problem. Acquiring and releasing is lock-free
+// from any thread. If all objects are in use, acquire() falls back to the heap (and the deleter
+// to delete), so the pool should be a bit larger than the number of objects in flight.
+//
+// Usage:
+//   ObjectPool<State, 4> pool;
+//   auto state = pool.acquire();   // ObjectPool<State, 4>::Handle
+//   *state = ...;
+//   state.reset();                 // back into the pool
+//
+template<class T, int capacity>
+class ObjectPool
+{
+public:
+	static_assert(capacity > 0, "the pool needs at least one object");
+
+	struct Releaser
+	{
+		ObjectPool* pool{ nullptr };
+
+		void operator()(T* object) const {
+			if (pool && pool->owns(object))
+				pool->push(static_cast<int>(object - pool->objects.data()));
+			else
+				delete object;
+		}
+	};
+	using Handle = std::unique_ptr<T, Releaser>;
+
+	ObjectPool() {
+		for (int i = 0; i < capacity; i++) {
+			next[i].store(i + 1 < capacity ? i + 1 : empty, std::memory_order_relaxed);
+		}
+		head.store(pack(0, 0), std::memory_order_release);
+	}
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	// All handles need to be released before the pool is destroyed
+	Handle acquire() {
+		const int i = pop();
+		if (i == empty) return Handle(new T(), Releaser{ this });
+		return Handle(&objects[i], Releaser{ this });
+	}
+
+	bool owns(const T* object) const { return object >= objects.data() && object < objects.data() + capacity; }
+
+private:
+	static constexpr int empty = -1;
+
+	static uint64_t pack(int index, uint32_t tag) { return (uint64_t{ tag } << 32) | static_cast<uint32_t>(index); }
+	static int indexOf(uint64_t h) { return static_cast<int>(static_cast<uint32_t>(h)); }
+	static uint32_t tagOf(uint64_t h) { return static_cast<uint32_t>(h >> 32); }
+
+	int pop() noexcept {
+		uint64_t old = head.load(std::memory_order_acquire);
+		while (indexOf(old) != empty) {
+			const uint64_t popped = pack(next[indexOf(old)].load(std::memory_order_relaxed), tagOf(old) + 1);
+			if (head.compare_exchange_weak(old, popped, std::memory_order_acq_rel, std::memory_order_acquire)) {
+				return indexOf(old);
+			}
+		}
+		return empty;
+	}
+
+	void push(int i) noexcept {
+		uint64_t old = head.load(std::memory_order_relaxed);
+		uint64_t pushed;
+		do {
+			next[i].store(indexOf(old), std::memory_order_relaxed);
+			pushed = pack(i, tagOf(old) + 1);
+		} while (!head.compare_exchange_weak(old, pushed, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	std::array<T, capacity> objects{};
+	std::array<std::atomic<int>, capacity> next;
+	std::atomic<uint64_t> head{ 0 };
+};
+
+
+//
+// Counting semaphore that the audio thread can post to.
+//
+// post() never locks and only enters the kernel to wake a waiting thread (sem_post(),
+// dispatch_semaphore_signal(), ReleaseSemaphore()), unlike notify_one() of a condition
+// variable, which needs the mutex to be held to not lose wakeups. Together with an atomic flag,
+// a worker sleeps until there is work without a timeout, and the semaphore is only posted
+// when the flag is raised:
+//
+// Usage:
+//   audio thread:  if (!pending.exchange(true)) semaphore.post();
+//   worker:        semaphore.wait(); if (pending.exchange(false)) work();
+//
+class Semaphore
+{
+public:
+	Semaphore();
+	~Semaphore();
+	Semaphore(const Semaphore&) = delete;
+	Semaphore& operator=(const Semaphore&) = delete;
+
+	void post();
+	void wait();
+
+private:
+	void* handle;
+};
+
+} // namespace Uberton
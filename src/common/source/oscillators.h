@@ -2,6 +2,9 @@
 // Basic oscillator classes to generate sine/rect/trig and more wave shapes
 // The current phase is handled internally and updated with each call to get().
 //
+// The block oscillators below render whole buffers (vectorized, no virtual call per sample)
+// and keep the phase in a wrapping fixed point accumulator.
+//
 // -----------------------------------------------------------------------------------------------------------------------------
 // This file is part of the Überton project. Copyright (C) 2021 Überton
 //
@@ -15,6 +18,10 @@
 #pragma once
 
 #include "vstmath.h"
+#include "simd_math.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
 
 namespace Uberton {
 
@@ -57,6 +64,8 @@ public:
 	double get() final {
 		double sample = std::sin(phase);
 		phase += phaseInc;
+		if (phase >= Math::twopi<double>())
+			phase -= Math::twopi<double>();
 		return sample;
 	}
 };
@@ -65,10 +74,12 @@ class SineOscillatorPow5 : public Oscillator
 {
 public:
 	double get() final {
-		//double sample = std::pow(std::sin(phase), 5);
-		double sample = std::pow(std::sin(phase), 5);
+		const double s = std::sin(phase);
+		const double s2 = s * s;
 		phase += phaseInc;
-		return sample;
+		if (phase >= Math::twopi<double>())
+			phase -= Math::twopi<double>();
+		return s2 * s2 * s;
 	}
 };
 
@@ -93,8 +104,220 @@ public:
 		phase += phaseInc;
 		if (phase >= Math::twopi<double>())
 			phase -= Math::twopi<double>();
-		return 2.0 * (abs(sample) - 0.5);
+		return 2.0 * (std::abs(sample) - 0.5);
+	}
+};
+
+
+
+// ----                   ----------------------------------------
+// ---- Block oscillators ----------------------------------------
+// ----                   ----------------------------------------
+
+enum class Waveform {
+	Sine,
+	SinePow5,
+	Rect,	 // PolyBLEP
+	Triangle // PolyBLAMP
+};
+
+//
+// Phase in [0, 1) as 32 bit fixed point number. The accumulator wraps around by itself, so the
+// precision of the phase does not degrade over time (unlike a floating point phase that is
+// only incremented).
+//
+class PhaseAccumulator
+{
+public:
+	void setIncrement(double frequency, double sampleRate) {
+		// limited to below Nyquist, the PolyBLEP corrections need an increment < 0.5
+		const double f = std::min(std::abs(frequency) / sampleRate, 0.499);
+		increment = static_cast<uint32_t>(std::llround(f * 4294967296.0));
+	}
+
+	// phase in [0, 1)
+	void setPhase(double newPhase) {
+		newPhase -= std::floor(newPhase);
+		phase = static_cast<uint32_t>(newPhase * 4294967296.0);
+	}
+
+	// Write the phases of the next numSamples samples to out and advance
+	void render(float* out, int numSamples) {
+		uint32_t p = phase;
+		for (int i = 0; i < numSamples; i++) {
+			out[i] = toFloat(p);
+			p += increment;
+		}
+		phase = p;
+	}
+
+	// phase increment per sample in [0, 0.5)
+	float getIncrement() const { return toFloat(increment); }
+
+private:
+	// the upper 24 bits are converted exactly
+	static float toFloat(uint32_t p) { return static_cast<float>(p >> 8) * (1.0f / 16777216.0f); }
+
+	uint32_t phase{ 0 };
+	uint32_t increment{ 0 };
+};
+
+namespace Detail {
+
+using Vec = Simd::Vec<float>;
+
+// 2-point PolyBLEP residual for a step of height 2 at phase 0
+inline Vec polyBLEP(Vec t, Vec dt) {
+	const Vec zero(0.f), one(1.f);
+	// 1 … 0 for t ∈ [0, dt) and 0 … 1 for t ∈ (1 - dt, 1)
+	const Vec after = one - t / dt;
+	const Vec before = one + (t - one) / dt;
+	return Simd::select(t < dt, zero - after * after, Simd::select(t > one - dt, before * before, zero));
+}
+
+// 2-point PolyBLAMP residual for a slope change of 1 per sample at phase 0
+inline Vec polyBLAMP(Vec t, Vec dt) {
+	const Vec zero(0.f), one(1.f), sixth(1.f / 6);
+	const Vec after = one - t / dt;
+	const Vec before = one + (t - one) / dt;
+	return Simd::select(t < dt, sixth * after * after * after, Simd::select(t > one - dt, sixth * before * before * before, zero));
+}
+
+// Waveform for phases u ∈ [0, 1) with phase increment dt
+template<Waveform waveform>
+inline Vec shape(Vec u, Vec dt) {
+	const Vec half(.5f), one(1.f);
+	if constexpr (waveform == Waveform::Sine || waveform == Waveform::SinePow5) {
+		// sin(2πu) = -sin(2π(u - ½)), the argument stays in [-π, π) where the polynomial is exact
+		const Vec s = Simd::sin((u - half) * Vec(-Math::twopi<float>()));
+		if constexpr (waveform == Waveform::Sine)
+			return s;
+		const Vec s2 = s * s;
+		return s2 * s2 * s;
+	}
+	else if constexpr (waveform == Waveform::Rect) {
+		// -1 for u < ½, 1 afterwards (like RectOscillator)
+		const Vec naive = Simd::select(u < half, Vec(-1.f), one);
+		Vec shifted = u + half;
+		shifted = Simd::select(shifted < one, shifted, shifted - one);
+		return naive + polyBLEP(shifted, dt) - polyBLEP(u, dt);
+	}
+	else {
+		// 1 at u = 0, -1 at u = ½ (like TriangleOscillator), the slope changes by ∓8 per cycle
+		const Vec naive = Vec(4.f) * Simd::abs(u - half) - one;
+		Vec shifted = u + half;
+		shifted = Simd::select(shifted < one, shifted, shifted - one);
+		const Vec slopeChange = Vec(8.f) * dt;
+		return naive + slopeChange * (polyBLAMP(shifted, dt) - polyBLAMP(u, dt));
+	}
+}
+
+} // namespace Detail
+
+//
+// Oscillator that renders blocks. The waveform is a template parameter, so there is no dispatch
+// per sample, and the wave shape is computed on whole vectors:
+//   - Sine: the polynomial sine of simd_math.h
+//   - SinePow5: sin⁵ by multiplication of the polynomial sine
+//   - Rect/Triangle: PolyBLEP/PolyBLAMP corrected (band limited up to the 2 point residuals)
+//
+// Usage:
+//   BlockOscillator<Waveform::Sine> osc;
+//   osc.setSampleRate(44100);
+//   osc.setFrequency(440);
+//   osc.render(out, numSamples);
+//
+template<Waveform waveform>
+class BlockOscillator
+{
+public:
+	void setSampleRate(double newSampleRate) {
+		sampleRate = newSampleRate;
+		phase.setIncrement(freq, sampleRate);
+	}
+
+	void setFrequency(double frequency) {
+		freq = frequency;
+		phase.setIncrement(freq, sampleRate);
+	}
+
+	// phase in radians like Oscillator::setPhase()
+	void setPhase(double radians) { phase.setPhase(radians * Math::r_twopi<double>()); }
+
+	// out[i] = gain · wave[i]
+	void render(float* out, int numSamples, float gain = 1) {
+		process(out, numSamples, gain, [](float* o, float y) { *o = y; });
 	}
+
+	// out[i] += gain · wave[i]
+	void renderAdd(float* out, int numSamples, float gain = 1) {
+		process(out, numSamples, gain, [](float* o, float y) { *o += y; });
+	}
+
+private:
+	static constexpr int blockSize = 64;
+	using Vec = Detail::Vec;
+
+	template<class Write>
+	void process(float* out, int numSamples, float gain, Write&& write) {
+		alignas(16) float u[blockSize];
+		const Vec dt(phase.getIncrement());
+		const Vec g(gain);
+		for (int start = 0; start < numSamples; start += blockSize) {
+			const int n = std::min(blockSize, numSamples - start);
+			phase.render(u, n);
+			int i = 0;
+			for (; i + Vec::size <= n; i += Vec::size) {
+				(g * Detail::shape<waveform>(Vec::load(u + i), dt)).store(u + i);
+			}
+			for (; i < n; i++) {
+				float tail[Vec::size]{};
+				tail[0] = u[i];
+				(g * Detail::shape<waveform>(Vec::load(tail), dt)).store(tail);
+				u[i] = tail[0];
+			}
+			for (int k = 0; k < n; k++) {
+				write(out + start + k, u[k]);
+			}
+		}
+	}
+
+	PhaseAccumulator phase;
+	double freq{ 0 };
+	double sampleRate{ 44100 };
+};
+
+//
+// A bank of oscillators of the same waveform (i.e. the excitation of all voices of an
+// instrument). render() adds the sum of all enabled oscillators with their gains to the output,
+// every oscillator is rendered vectorized over the samples.
+//
+template<Waveform waveform, int maxOscillators>
+class OscillatorBank
+{
+public:
+	void setSampleRate(double sampleRate) {
+		for (auto& osc : oscillators) {
+			osc.setSampleRate(sampleRate);
+		}
+	}
+
+	void setFrequency(int k, double frequency) { oscillators[k].setFrequency(frequency); }
+	void setPhase(int k, double radians) { oscillators[k].setPhase(radians); }
+
+	// gain 0 disables the oscillator
+	void setGain(int k, float gain) { gains[k] = gain; }
+	float getGain(int k) const { return gains[k]; }
+
+	void render(float* out, int numSamples) {
+		for (int k = 0; k < maxOscillators; k++) {
+			if (gains[k] != 0) oscillators[k].renderAdd(out, numSamples, gains[k]);
+		}
+	}
+
+private:
+	std::array<BlockOscillator<waveform>, maxOscillators> oscillators;
+	std::array<float, maxOscillators> gains{};
 };
 
 } // namespace Uberton
\ No newline at end of file
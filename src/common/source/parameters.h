@@ -17,13 +17,29 @@
 #include <public.sdk/source/vst/vsteditcontroller.h>
 #include <base/source/fstreamer.h>
 #include "pluginterfaces/base/ustring.h"
+#include "simd.h"
+#include <algorithm>
 #include <array>
 #include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace Uberton {
 using namespace Steinberg;
 using namespace Steinberg::Vst;
 
+/// Index of the lowest set bit, x must not be 0
+inline int lowestSetBit(uint64 x) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
 /*
  * Wrapper for a global parameter state with N parameters of type ParamValue (double).
  * Provides member functions for loading and storing the entire state through
@@ -32,6 +48,17 @@ using namespace Steinberg::Vst;
  * A bypass is always implemented and stored/loaded as well as a version number
  * because adding a bypass parameter in a later version of a plugin would be hard
  * otherwise.
+ *
+ * Changes are tracked with one dirty bit per parameter, so a processor only needs to
+ * recompute what depends on the parameters that actually changed:
+ *
+ *   paramState.set(id, value);                       // from the parameter queues
+ *   paramState.takeChanges(newState);                // from a state transfer (i.e. a preset load)
+ *   paramState.forEachDirty([](int32 id) { ... });   // once per block, clears the bits
+ *
+ * The generation counter is incremented with every change. Consumers that do not own the
+ * dirty bits can compare it with the last generation they have seen. Writing through
+ * operator[] or params is not tracked (i.e. for initial values).
  */
 template<uint32 N>
 struct UniformParamState
@@ -43,6 +70,60 @@ struct UniformParamState
 	bool isBypassed() const { return bypass; }
 	void setBypass(bool state) { bypass = state; }
 
+	/// Set a parameter and mark it as dirty if the value has changed
+	void set(int32 id, ParamValue value) {
+		if (params[id] == value) return;
+		params[id] = value;
+		markDirty(id);
+	}
+
+	/// Copy parameters, bypass and version from another state. Only the parameters with
+	/// different values are marked as dirty.
+	void takeChanges(const UniformParamState& other) {
+		for (uint32 id = 0; id < N; id++) {
+			set(id, other.params[id]);
+		}
+		bypass = other.bypass;
+		version = other.version;
+	}
+
+	void markDirty(int32 id) {
+		dirtyBits[id / 64] |= uint64{ 1 } << (id % 64);
+		generation++;
+	}
+
+	void markAllDirty() {
+		dirtyBits.fill(~uint64{ 0 });
+		if (N % 64 != 0) dirtyBits.back() = (uint64{ 1 } << (N % 64)) - 1;
+		generation++;
+	}
+
+	bool isDirty(int32 id) const { return (dirtyBits[id / 64] >> (id % 64)) & 1; }
+
+	bool isAnyDirty() const {
+		for (uint64 word : dirtyBits) {
+			if (word) return true;
+		}
+		return false;
+	}
+
+	void clearDirty() { dirtyBits.fill(0); }
+
+	/// Call f(id) for each dirty parameter in ascending order and clear the dirty bits
+	template<class F>
+	void forEachDirty(F&& f) {
+		for (uint32 w = 0; w < numWords; w++) {
+			uint64 word = dirtyBits[w];
+			dirtyBits[w] = 0;
+			while (word) {
+				f(static_cast<int32>(w * 64 + lowestSetBit(word)));
+				word &= word - 1;
+			}
+		}
+	}
+
+	uint64 getGeneration() const { return generation; }
+
 	tresult getState(IBStream* stream) {
 		IBStreamer s(stream, kLittleEndian);
 		if (!s.writeInt64u(version)) return kResultFalse;
@@ -61,13 +142,23 @@ struct UniformParamState
 		if (!s.readInt64u(version)) return kResultFalse;
 		if (!s.readBool(bypass)) return kResultFalse;
 
+		// Parameters that have been appended in a later version keep their current values when
+		// an older (shorter) state is loaded.
 		for (uint32 id = 0; id < N; id++) {
-			if (!s.readDouble(params[id])) return kResultFalse;
+			ParamValue value;
+			if (!s.readDouble(value)) return id > 0 ? kResultOk : kResultFalse;
+			set(id, value);
 		}
 		return kResultOk;
 	}
 
 	tresult setComponentState(IBStream* stream, EditController& controller) {
+		// start from the defaults of the controller, so that parameters missing in an older state
+		// are reset like in the processor
+		for (uint32 id = 0; id < N; id++) {
+			if (Parameter* parameter = controller.getParameterObject(id))
+				set(id, parameter->getInfo().defaultNormalizedValue);
+		}
 		if (setState(stream) != kResultOk) return kResultFalse;
 
 		for (uint32 id = 0; id < N; id++) {
@@ -89,6 +180,11 @@ struct UniformParamState
 #endif
 		return params[id];
 	}
+
+private:
+	static constexpr uint32 numWords = (N + 63) / 64;
+	std::array<uint64, numWords> dirtyBits{};
+	uint64 generation{ 0 };
 };
 
 
@@ -137,44 +233,87 @@ inline double scaledToNormalized(double value, double min, double max) {
 
 /* 
  * Linear ramped parameter. 
- * step() needs to be called each sample
+ * Either step() needs to be called each sample or render() once per block.
  */
 template<class FloatType>
 class RampedValue
 {
 public:
-	RampedValue(FloatType value, FloatType numRampSamples)
-		: value(value), targetValue(value), numRampSamples(numRampSamples) {}
+	using Vec = Simd::Vec<FloatType>;
+
+	RampedValue() = default;
+	RampedValue(FloatType value, int numRampSamples)
+		: value(value), targetValue(value), numRampSamples(std::max(1, numRampSamples)) {}
+
+	// applies to the next ramp
+	void setRampLength(int numSamples) noexcept {
+		numRampSamples = std::max(1, numSamples);
+	}
 
 	void set(FloatType newValue) noexcept {
 		if (newValue == targetValue) return;
 		targetValue = newValue;
 		countdown = numRampSamples;
-		delta = (targetValue - value) / numRampSamples;
+		delta = (value - targetValue) / numRampSamples;
+	}
+
+	// jump to the value without ramp
+	void reset(FloatType newValue) noexcept {
+		value = targetValue = newValue;
+		countdown = 0;
 	}
 
 	FloatType get() const noexcept {
 		return value;
 	}
 
+	FloatType getTarget() const noexcept {
+		return targetValue;
+	}
+
+	bool isRamping() const noexcept {
+		return countdown > 0;
+	}
+
 	// returns true when finished
 	bool step() noexcept {
 		if (countdown <= 0) return true;
 		countdown--;
-		value = targetValue + countdown * delta;
-		//value += ramp; // might over-/undershoot a bit because of fp precision
+		value = targetValue + countdown * delta; // no accumulated error, ends exactly at the target
 		return false;
+	}
 
-		delta *= countdown;
-		value += delta;
+	// Write the values of the next numSamples calls of step() to out
+	void render(FloatType* out, int numSamples) noexcept {
+		if (countdown <= 0) {
+			std::fill(out, out + numSamples, value);
+			return;
+		}
+		// out[i] = target + max(countdown - 1 - i, 0)·delta
+		FloatType laneOffsets[Vec::size];
+		for (int k = 0; k < Vec::size; k++) {
+			laneOffsets[k] = static_cast<FloatType>(countdown - 1 - k);
+		}
+		const Vec target(targetValue), d(delta), zero(FloatType(0)), advance(FloatType(Vec::size));
+		Vec remaining = Vec::load(laneOffsets);
+		int i = 0;
+		for (; i + Vec::size <= numSamples; i += Vec::size) {
+			(target + max(remaining, zero) * d).store(out + i);
+			remaining = remaining - advance;
+		}
+		for (; i < numSamples; i++) {
+			out[i] = targetValue + std::max(countdown - 1 - i, 0) * delta;
+		}
+		countdown = std::max(countdown - numSamples, 0);
+		value = targetValue + countdown * delta;
 	}
 
 private:
-	FloatType value;
-	FloatType targetValue;
-	FloatType delta{ 0 };
+	FloatType value{ 0 };
+	FloatType targetValue{ 0 };
+	FloatType delta{ 0 }; // (start - target) / numRampSamples
 	int countdown{ 0 };
-	const FloatType numRampSamples;
+	int numRampSamples{ 1 };
 };
 
 
@@ -0,0 +1,153 @@
+// Precomputed modal time steps for all MIDI pitches
+//  - one table of time functions per pitch for a sample rate, dampening and velocity
+//  - tables for new settings are built on a background thread
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "lockfree.h"
+#include "vstmath.h"
+#include <array>
+#include <atomic>
+#include <thread>
+
+namespace Uberton {
+namespace Math {
+
+//
+// Setting the frequency of a resonator computes its eigenvalues and an exponential per mode,
+// which is too expensive to do for every note on the audio thread. This class holds the time
+// functions (see ResonatorBase) for every pitch of Math::frequencyTable, so a note on only needs
+// to look up a row.
+//
+// prepare() builds the table synchronously (i.e. in setupProcessing()). While the worker is
+// running (start() and stop() in setActive()), the audio thread posts new settings with
+// request() (lock-free) and picks up the finished table with update(). The settings are passed
+// through triple buffers like in EigenFunctionWorker, the worker uses its own resonator instance.
+//
+// Usage:
+//   tables.prepare({ sampleRate, dampening, velocity });         // not real-time safe
+//   tables.start();                                              // not real-time safe
+//   tables.request({ sampleRate, newDampening, velocity });      // audio thread
+//   if (tables.update()) { /* table() has changed */ }           // audio thread
+//   const auto* timeFunctions = tables.table()[pitch];
+//
+template<class Resonator, int numPitches = 128>
+class PitchTables
+{
+public:
+	using real = typename Resonator::real;
+	using scalar = typename Resonator::scalar;
+	static constexpr int N = Resonator::maxOrder();
+	static_assert(numPitches <= 128, "frequencyTable has 128 entries");
+
+	struct Settings
+	{
+		real sampleRate{ 44100 };
+		real dampening{ 1 };
+		real velocity{ 1 };
+
+		bool operator==(const Settings& other) const {
+			return sampleRate == other.sampleRate && dampening == other.dampening && velocity == other.velocity;
+		}
+		bool operator!=(const Settings& other) const { return !(*this == other); }
+	};
+
+	struct Table
+	{
+		Settings settings;
+		std::array<std::array<scalar, N>, numPitches> timeFunctions;
+
+		const scalar* operator[](int pitch) const { return timeFunctions[pitch].data(); }
+	};
+
+	PitchTables() = default;
+	PitchTables(const PitchTables&) = delete;
+	PitchTables& operator=(const PitchTables&) = delete;
+	~PitchTables() { stop(); }
+
+	// Build the table for the settings before processing starts, the worker is stopped for it
+	void prepare(const Settings& settings) {
+		const bool running = thread.joinable();
+		stop();
+		build(settings, tables.writeBuffer());
+		tables.publish();
+		tables.update();
+		requested = settings;
+		requests.update(); // drop requests for the previous settings
+		pending.store(false);
+		if (running) start();
+	}
+
+	void start() {
+		if (thread.joinable()) return;
+		quit = false;
+		thread = std::thread([this] { run(); });
+	}
+
+	// Requests that are posted while the worker is stopped are built after the next start()
+	void stop() {
+		if (!thread.joinable()) return;
+		quit.store(true);
+		wakeup.post();
+		thread.join();
+	}
+
+	// Audio thread: request a table for new settings. Only the latest request is built.
+	void request(const Settings& settings) {
+		if (settings == requested) return;
+		requested = settings;
+		requests.writeBuffer() = settings;
+		requests.publish();
+		if (!pending.exchange(true, std::memory_order_acq_rel)) wakeup.post();
+	}
+
+	// Audio thread: switch to the newest finished table, returns true if there was one
+	bool update() { return tables.update(); }
+
+	// Audio thread: the current table, valid until the next call of update()
+	const Table& table() const { return tables.readBuffer(); }
+
+private:
+	void run() {
+		while (!quit) {
+			if (pending.exchange(false, std::memory_order_acq_rel) && requests.update()) {
+				build(requests.readBuffer(), tables.writeBuffer());
+				tables.publish();
+			}
+			wakeup.wait();
+		}
+	}
+
+	void build(const Settings& settings, Table& table) {
+		table.settings = settings;
+		resonator.setSampleRate(settings.sampleRate);
+		for (int pitch = 0; pitch < numPitches; pitch++) {
+			resonator.setFreqDampeningAndVelocity(frequencyTable[pitch], settings.dampening, settings.velocity);
+			table.timeFunctions[pitch] = resonator.timeFunctions;
+		}
+	}
+
+	Resonator resonator; // only used by build()
+	TripleBuffer<Table> tables;
+	TripleBuffer<Settings> requests;
+	Settings requested; // audio thread
+
+	std::thread thread;
+	Semaphore wakeup;
+	std::atomic<bool> pending{ false }; // there is a new request, wakeup has been posted
+	std::atomic<bool> quit{ false };
+};
+
+} // namespace Math
+} // namespace Uberton
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "vstmath.h"
+#include "simd_math.h"
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -39,12 +40,16 @@ namespace Math {
 //	T:		float type (float/double)
 //	d:		dimension (1, 2, ...)
 //	N:		(maximum) number of eigenvalues taken into acount
-//	channels: number of input/output "channels" or positions
+//	channels: number of input "channels" or positions
+//	outputChannels: number of output positions (i.e. one per speaker of a surround layout)
 //
 // The parent class needs to implement the functions
 //   - scalar eigenValueSqrt(int i);
-//   - scalar eigenFunction(int i, const SpaceVec& x); and
+//   - scalar eigenFunction(int i, const SpaceVec& x);
+//   - void eigenFunctions(const SpaceVec& x, scalar* out, int n); and
 //   - void setDesiredBaseFrequency(real freq, real dampening, real velocity);
+// where eigenFunctions() evaluates the first n eigenfunctions at x at once. It is used
+// for all position updates and can share work between the modes.
 //
 // All positions should be normalized to [0, 1]. The same applies to the eigenFunction()
 // function that the parent class needs to implement. If it features properties like a
@@ -63,21 +68,29 @@ namespace Math {
 // with spatial eigenfunctions φ(x) and corresponding eigenvalues k².
 //
 
-template<class Parent, class T, int d, int N, int channels>
+template<class Parent, class T, int d, int N, int channels, int outputChannels = channels>
 class ResonatorBase : public Parent
 {
 	static_assert(d > 0, "template parameter d needs to be greater than 0");
 	static_assert(N > 0, "template parameter N needs to be greater than 0");
 	static_assert(channels > 0, "template parameter channels needs to be greater than 0");
+	static_assert(outputChannels > 0, "template parameter outputChannels needs to be greater than 0");
 
 public:
 	using real = T;
 	using scalar = std::complex<real>;
 	using SpaceVec = Uberton::Math::Vector<T, d>;
+	using EigenValues = Parent;
 
 	template<class TT, int n>
 	using array = std::array<TT, n>;
 
+	// eigenfunction evaluations (weights) at one position per channel
+	template<std::size_t n>
+	using EFArrayN = std::array<array<scalar, N>, n>;
+	using EFArray = EFArrayN<channels>;
+	using OutputEFArray = EFArrayN<outputChannels>;
+
 	/// Initialize resonator with sample rate in Hz (i.e. 44100)
 	void setSampleRate(T sampleRate) {
 		this->deltaT = T{ 1. } / sampleRate;
@@ -87,6 +100,8 @@ public:
 	/// The actual order to which the system response will be computed as well as excited
 	/// can be set lower than N (the max order)
 	void setOrder(int order) {
+		finishRamp(inputRamp, inputPosEF);
+		finishRamp(outputRamp, outputPosEF);
 		this->nOrder = std::max(1, std::min(N, order));
 	}
 
@@ -101,33 +116,97 @@ public:
 	}
 
 	/// Compute next time step and get the evaluations at the output positions
-	array<real, channels> next() {
+	array<real, outputChannels> next() {
 		evolve();
-		array<real, channels> results{ 0 };
-		for (int ch = 0; ch < channels; ++ch) {
+		array<real, outputChannels> results{ 0 };
+		for (int ch = 0; ch < outputChannels; ++ch) {
 			for (int i = 0; i < nOrder; ++i) {
 				results[ch] += (amplitudes[i] * outputPosEF[ch][i]).real();
 			}
 		}
+		advance(inputRamp, inputPosEF);
+		advance(outputRamp, outputPosEF);
 		return results;
 	}
 
-	/// Set the "listening" positions (normalized to [0,1])
-	void setOutputPositions(const array<SpaceVec, channels>& outPositions) {
-		for (int ch = 0; ch < channels; ++ch) {
-			for (int i = 0; i < N; ++i) {
-				outputPosEF[ch][i] = this->eigenFunction(i, outPositions[ch]);
+	/// Process a block of samples. This is equivalent to calling delta() with in[ch][s] and
+	/// next() for each sample s and writing the results to out[ch][s], but iterates mode by mode
+	/// so that each amplitude stays in a register for the whole block. Running weight ramps are
+	/// evaluated in closed form as w + k·step (one extra multiply-add per mode and channel).
+	/// in and out must not point to the same buffers.
+	///
+	/// numInputs and numOutputs are the number of audio channels and may be 1 or channels
+	/// (outputChannels respectively):
+	///   - one input excites all input positions with the same signal (the weights are summed
+	///     once per block, so the excitation costs the same as for a single position),
+	///   - one output is the mean of all output positions.
+	/// If all output positions have the same weights, the projection runs once and the result is
+	/// copied to the other outputs. With more than two outputs, the modes are evolved once per
+	/// sub-block and projected to all outputs afterwards (see processModesProjected()).
+	template<int numInputs = channels, int numOutputs = outputChannels>
+	void processBlock(const real* const* in, real* const* out, int numSamples) {
+		static_assert(numInputs == 1 || numInputs == channels, "numInputs needs to be 1 or channels");
+		static_assert(numOutputs == 1 || numOutputs == outputChannels, "numOutputs needs to be 1 or outputChannels");
+
+		const int inRampLength = std::min(numSamples, inputRamp.samplesLeft);
+		const int outRampLength = std::min(numSamples, outputRamp.samplesLeft);
+
+		const auto inputWeights = weightsFor<numInputs>(inputPosEF, inputRamp, real(1), combinedInput);
+		if constexpr (numOutputs > 1) {
+			if (identicalWeights(outputPosEF, outputRamp)) {
+				const Weights<1> outputWeights{ { outputPosEF[0].data() }, { outputRamp.step[0].data() } };
+				processModes<numInputs, 1>(in, out, numSamples, inputWeights, outputWeights, inRampLength, outRampLength);
+				for (int ch = 1; ch < numOutputs; ++ch) {
+					std::copy(out[0], out[0] + numSamples, out[ch]);
+				}
+				finishBlock(numSamples);
+				return;
 			}
 		}
+		const auto outputWeights = weightsFor<numOutputs>(outputPosEF, outputRamp, real(1) / outputChannels, combinedOutput);
+		if constexpr (numOutputs > 2)
+			processModesProjected<numInputs, numOutputs>(in, out, numSamples, inputWeights, outputWeights, inRampLength, outRampLength);
+		else
+			processModes<numInputs, numOutputs>(in, out, numSamples, inputWeights, outputWeights, inRampLength, outRampLength);
+		finishBlock(numSamples);
+	}
+
+	/// Set the "listening" positions (normalized to [0,1])
+	void setOutputPositions(const array<SpaceVec, outputChannels>& outPositions) {
+		setPositions(outputRamp, outputPosEF, outPositions.data());
 	}
 
 	/// Set the "playing" or exciting position (normalized to [0,1])
 	void setInputPositions(const array<SpaceVec, channels>& inPositions) {
-		for (int ch = 0; ch < channels; ++ch) {
-			for (int i = 0; i < N; ++i) {
-				inputPosEF[ch][i] = this->eigenFunction(i, inPositions[ch]);
-			}
-		}
+		setPositions(inputRamp, inputPosEF, inPositions.data());
+	}
+
+	/// Versions of the above (and of the fade functions below) for arrays with more positions.
+	/// The surplus positions are ignored, so the same arrays can be used for inputs and outputs.
+	template<std::size_t n>
+	void setOutputPositions(const std::array<SpaceVec, n>& outPositions) {
+		static_assert(static_cast<int>(n) >= outputChannels);
+		setPositions(outputRamp, outputPosEF, outPositions.data());
+	}
+
+	template<std::size_t n>
+	void setInputPositions(const std::array<SpaceVec, n>& inPositions) {
+		static_assert(static_cast<int>(n) >= channels);
+		setPositions(inputRamp, inputPosEF, inPositions.data());
+	}
+
+	/// Crossfade to eigenfunction evaluations at new listening positions (i.e. computed
+	/// elsewhere with eigenFunctions()) over the next numSamples calls to next().
+	template<std::size_t n>
+	void fadeOutputPositionEF(const EFArrayN<n>& ef, int numSamples) {
+		startRamp(outputRamp, outputPosEF, ef, numSamples);
+	}
+
+	/// Crossfade to eigenfunction evaluations at new exciting positions over the next
+	/// numSamples calls to next().
+	template<std::size_t n>
+	void fadeInputPositionEF(const EFArrayN<n>& ef, int numSamples) {
+		startRamp(inputRamp, inputPosEF, ef, numSamples);
 	}
 
 	/// Set the base frequency (redirect to adjust i.e. the system size), dampening coefficient
@@ -139,6 +218,15 @@ public:
 		update();
 	}
 
+	/// Same as above with time functions that have been computed elsewhere (i.e. by another
+	/// resonator with the same settings, sample rate and dimension)
+	void setFreqDampeningAndVelocity(real freq, real dampening, real velocity, const array<scalar, N>& precomputedTimeFunctions) {
+		this->b = dampening;
+		this->c = velocity;
+		this->setDesiredBaseFrequency(freq, dampening, velocity);
+		timeFunctions = precomputedTimeFunctions;
+	}
+
 	/// Clear the system, setting all amplitudes to zero
 	void clear() {
 		for (int i = 0; i < N; ++i) {
@@ -151,12 +239,20 @@ public:
 	static constexpr int maxDimension() { return d; }
 	static constexpr int maxOrder() { return N; }
 	static constexpr int numChannels() { return channels; }
+	static constexpr int numOutputChannels() { return outputChannels; }
 
 protected:
 	void update() {
 		constexpr scalar imagUnit = scalar(0, 1);
+		array<real, N> re, im;
+		for (int i = 0; i < N; i++) {
+			const scalar exponent = imagUnit * this->frequency(i) * deltaT;
+			re[i] = exponent.real();
+			im[i] = exponent.imag();
+		}
+		Simd::cexp(re.data(), im.data(), re.data(), im.data(), N);
 		for (int i = 0; i < N; i++) {
-			timeFunctions[i] = std::exp(imagUnit * this->frequency(i) * deltaT);
+			timeFunctions[i] = scalar(re[i], im[i]);
 		}
 	}
 
@@ -173,6 +269,212 @@ protected:
 		return (imagUnit * b + std::sqrt(k * k * c * c - b * b)); // ib + √(k²c²-b²)
 	}
 
+	// Linear ramp from the current weights to a target. As the output is linear in the weights,
+	// this is the same as crossfading the outputs for the old and new positions. Only the first
+	// nOrder weights are ramped, the target is copied entirely when the ramp ends.
+	template<std::size_t n>
+	struct WeightRamp
+	{
+		EFArrayN<n> target{};
+		EFArrayN<n> step{};
+		int samplesLeft{ 0 };
+	};
+
+	template<std::size_t n>
+	void setPositions(WeightRamp<n>& ramp, EFArrayN<n>& weights, const SpaceVec* positions) {
+		ramp.samplesLeft = 0;
+		for (int ch = 0; ch < static_cast<int>(n); ++ch) {
+			this->eigenFunctions(positions[ch], weights[ch].data(), N);
+		}
+	}
+
+	template<std::size_t n, std::size_t m>
+	void startRamp(WeightRamp<n>& ramp, EFArrayN<n>& weights, const EFArrayN<m>& target, int numSamples) {
+		static_assert(m >= n);
+		std::copy(target.begin(), target.begin() + n, ramp.target.begin());
+		if (numSamples <= 1) {
+			weights = ramp.target;
+			ramp.samplesLeft = 0;
+			return;
+		}
+		const real r_numSamples = real(1) / numSamples;
+		for (int ch = 0; ch < static_cast<int>(n); ++ch) {
+			for (int i = 0; i < nOrder; ++i) {
+				ramp.step[ch][i] = (target[ch][i] - weights[ch][i]) * r_numSamples;
+			}
+		}
+		ramp.samplesLeft = numSamples;
+	}
+
+	template<std::size_t n>
+	void finishRamp(WeightRamp<n>& ramp, EFArrayN<n>& weights) {
+		if (ramp.samplesLeft == 0) return;
+		weights = ramp.target;
+		ramp.samplesLeft = 0;
+	}
+
+	template<std::size_t n>
+	void advance(WeightRamp<n>& ramp, EFArrayN<n>& weights, int numSamples = 1) {
+		if (ramp.samplesLeft == 0) return;
+		if (ramp.samplesLeft <= numSamples) {
+			weights = ramp.target;
+			ramp.samplesLeft = 0;
+			return;
+		}
+		ramp.samplesLeft -= numSamples;
+		const real k = static_cast<real>(numSamples);
+		for (int ch = 0; ch < static_cast<int>(n); ++ch) {
+			for (int i = 0; i < nOrder; ++i) {
+				weights[ch][i] += k * ramp.step[ch][i];
+			}
+		}
+	}
+
+	// Weights (and ramp steps) per audio channel for processBlock()
+	template<int n>
+	struct Weights
+	{
+		array<const scalar*, n> weights;
+		array<const scalar*, n> steps;
+	};
+
+	struct CombinedWeights
+	{
+		array<scalar, N> weights{};
+		array<scalar, N> steps{};
+	};
+
+	template<int numAudioChannels, std::size_t n>
+	Weights<numAudioChannels> weightsFor(const EFArrayN<n>& ef, const WeightRamp<n>& ramp, real scale, CombinedWeights& combined) {
+		Weights<numAudioChannels> result;
+		if constexpr (numAudioChannels == static_cast<int>(n)) {
+			for (int ch = 0; ch < numAudioChannels; ++ch) {
+				result.weights[ch] = ef[ch].data();
+				result.steps[ch] = ramp.step[ch].data();
+			}
+		} else {
+			// scale · Σ weights, the ramp steps are combined the same way
+			for (int i = 0; i < nOrder; ++i) {
+				scalar w = 0, step = 0;
+				for (int ch = 0; ch < static_cast<int>(n); ++ch) {
+					w += ef[ch][i];
+					step += ramp.step[ch][i];
+				}
+				combined.weights[i] = scale * w;
+				combined.steps[i] = scale * step;
+			}
+			result.weights[0] = combined.weights.data();
+			result.steps[0] = combined.steps.data();
+		}
+		return result;
+	}
+
+	template<std::size_t n>
+	bool identicalWeights(const EFArrayN<n>& ef, const WeightRamp<n>& ramp) const {
+		const bool ramping = ramp.samplesLeft > 0;
+		for (int ch = 1; ch < static_cast<int>(n); ++ch) {
+			if (!std::equal(ef[0].begin(), ef[0].begin() + nOrder, ef[ch].begin())) return false;
+			if (ramping && !std::equal(ramp.step[0].begin(), ramp.step[0].begin() + nOrder, ramp.step[ch].begin())) return false;
+		}
+		return true;
+	}
+
+	// The kernel of processBlock() for a fixed number of audio channels
+	template<int numInputs, int numOutputs>
+	void processModes(const real* const* in, real* const* out, int numSamples, const Weights<numInputs>& inW, const Weights<numOutputs>& outW, int inRampLength, int outRampLength) {
+		for (int ch = 0; ch < numOutputs; ++ch) {
+			std::fill(out[ch], out[ch] + numSamples, real(0));
+		}
+		const bool ramping = inRampLength > 0 || outRampLength > 0;
+
+		for (int i = 0; i < nOrder; ++i) {
+			scalar a = amplitudes[i];
+			const scalar tf = timeFunctions[i];
+			if (!ramping) {
+				for (int s = 0; s < numSamples; ++s) {
+					for (int ch = 0; ch < numInputs; ++ch) {
+						a += in[ch][s] * inW.weights[ch][i];
+					}
+					a *= tf;
+					for (int ch = 0; ch < numOutputs; ++ch) {
+						out[ch][s] += (a * outW.weights[ch][i]).real();
+					}
+				}
+			} else {
+				for (int s = 0; s < numSamples; ++s) {
+					const real kIn = static_cast<real>(std::min(s, inRampLength));
+					const real kOut = static_cast<real>(std::min(s, outRampLength));
+					for (int ch = 0; ch < numInputs; ++ch) {
+						a += in[ch][s] * (inW.weights[ch][i] + kIn * inW.steps[ch][i]);
+					}
+					a *= tf;
+					for (int ch = 0; ch < numOutputs; ++ch) {
+						out[ch][s] += (a * (outW.weights[ch][i] + kOut * outW.steps[ch][i])).real();
+					}
+				}
+			}
+			amplitudes[i] = a;
+		}
+	}
+
+	// Kernel for many outputs: each mode is evolved over a sub-block and its amplitudes are
+	// stored. Then the sub-block is projected to all outputs as a rank-1 update
+	// out[ch][s] += Re(a[s]·w[ch]), so that over all modes the projection is the dense
+	// product of the (outputs × modes) weight matrix and the (modes × samples) amplitudes.
+	// The inner loops run over contiguous samples and vectorize.
+	template<int numInputs, int numOutputs>
+	void processModesProjected(const real* const* in, real* const* out, int numSamples, const Weights<numInputs>& inW, const Weights<numOutputs>& outW, int inRampLength, int outRampLength) {
+		for (int ch = 0; ch < numOutputs; ++ch) {
+			std::fill(out[ch], out[ch] + numSamples, real(0));
+		}
+		alignas(16) array<real, projectionBlockSize> re, im, kOut;
+		// after a ramp has ended within the block the weights stay at weights + outRampLength·steps
+		const bool outRamping = outRampLength > 0;
+
+		for (int blockStart = 0; blockStart < numSamples; blockStart += projectionBlockSize) {
+			const int blockSize = std::min(projectionBlockSize, numSamples - blockStart);
+			for (int s = 0; s < blockSize; ++s) {
+				kOut[s] = static_cast<real>(std::min(blockStart + s, outRampLength));
+			}
+
+			for (int i = 0; i < nOrder; ++i) {
+				scalar a = amplitudes[i];
+				const scalar tf = timeFunctions[i];
+				for (int s = 0; s < blockSize; ++s) {
+					const real kIn = static_cast<real>(std::min(blockStart + s, inRampLength));
+					for (int ch = 0; ch < numInputs; ++ch) {
+						a += in[ch][blockStart + s] * (inW.weights[ch][i] + kIn * inW.steps[ch][i]);
+					}
+					a *= tf;
+					re[s] = a.real();
+					im[s] = a.imag();
+				}
+				amplitudes[i] = a;
+
+				for (int ch = 0; ch < numOutputs; ++ch) {
+					real* o = out[ch] + blockStart;
+					const real wRe = outW.weights[ch][i].real(), wIm = outW.weights[ch][i].imag();
+					if (!outRamping) {
+						for (int s = 0; s < blockSize; ++s) {
+							o[s] += re[s] * wRe - im[s] * wIm;
+						}
+					} else {
+						const real sRe = outW.steps[ch][i].real(), sIm = outW.steps[ch][i].imag();
+						for (int s = 0; s < blockSize; ++s) {
+							o[s] += re[s] * (wRe + kOut[s] * sRe) - im[s] * (wIm + kOut[s] * sIm);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void finishBlock(int numSamples) {
+		absoluteTime += numSamples * deltaT;
+		advance(inputRamp, inputPosEF, numSamples);
+		advance(outputRamp, outputPosEF, numSamples);
+	}
+
 private:
 public:
 	T absoluteTime{ 0 };			  // not really needed
@@ -183,10 +485,19 @@ public:
 	array<scalar, N> timeFunctions{}; // precomputed exponential time functions
 
 	// eigenfunction evaluations at input/output positions
-	array<array<scalar, N>, channels> outputPosEF{};
-	array<array<scalar, N>, channels> inputPosEF{};
+	OutputEFArray outputPosEF{};
+	EFArray inputPosEF{};
+
+	WeightRamp<channels> inputRamp{};
+	WeightRamp<outputChannels> outputRamp{};
+
+	// scratch for processBlock() with fewer audio channels than positions
+	CombinedWeights combinedInput{};
+	CombinedWeights combinedOutput{};
 
 	int nOrder{ N };
+
+	static constexpr int projectionBlockSize = 64;
 };
 
 
@@ -210,6 +521,21 @@ public:
 		return std::sin((i + 1) * pi<real>() * x[0]); // no division by length as x is normalized
 	}
 
+	void eigenFunctions(const SpaceVec& x, scalar* out, int n) const {
+		constexpr int chunkSize = 64;
+		std::array<real, chunkSize> values;
+		for (int start = 0; start < n; start += chunkSize) {
+			const int count = std::min(chunkSize, n - start);
+			for (int i = 0; i < count; i++) {
+				values[i] = (start + i + 1) * pi<real>() * x[0];
+			}
+			Simd::sin(values.data(), values.data(), count);
+			for (int i = 0; i < count; i++) {
+				out[start + i] = values[i];
+			}
+		}
+	}
+
 	void setDesiredBaseFrequency(real f, real b, real c) {
 		const real w = 2 * pi<real>() * f;
 		length = pi<real>() * c / std::sqrt(w * w + b * b);
@@ -220,8 +546,8 @@ private:
 };
 
 
-template<class T, int N, int channels>
-class StringResonator : public ResonatorBase<StringEigenValues<T>, T, 1, N, channels>
+template<class T, int N, int channels, int outputChannels = channels>
+class StringResonator : public ResonatorBase<StringEigenValues<T>, T, 1, N, channels, outputChannels>
 {
 };
 
@@ -263,6 +589,24 @@ public:
 		return result;
 	}
 
+	void eigenFunctions(const SpaceVec& x, scalar* out, int n) const {
+		// one vectorized sine per dimension over all modes
+		std::array<real, N> arguments, product;
+		product.fill(1);
+		for (int j = 0; j < dim; ++j) {
+			for (int i = 0; i < n; i++) {
+				arguments[i] = ksAndEV[i][j] * pi * x[j];
+			}
+			Simd::sin(arguments.data(), arguments.data(), n);
+			for (int i = 0; i < n; i++) {
+				product[i] *= arguments[i];
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			out[i] = product[i];
+		}
+	}
+
 	void setDesiredBaseFrequency(real f, real b, real c) {
 		const real w = 2 * pi * f;
 		length = pi * c * std::sqrt(d / (w * w + b * b));
@@ -316,8 +660,8 @@ private:
 };
 
 
-template<class T, int d, int N, int channels>
-class CubeResonator : public ResonatorBase<CubeEigenValues<T, d, N>, T, d, N, channels>
+template<class T, int d, int N, int channels, int outputChannels = channels>
+class CubeResonator : public ResonatorBase<CubeEigenValues<T, d, N>, T, d, N, channels, outputChannels>
 {
 };
 
@@ -485,6 +829,12 @@ struct CubeEWPStorage
 #include "cube_ewp_n=200.h"
 //#include "cube_ewp_n=50.h"
 
+// The storage is built once and shared by all resonators (of the same type)
+template<class T, int maxDim, int N>
+const CubeEWPStorage<T, maxDim>& getSharedCubeEWPStorage() {
+	static const CubeEWPStorage<T, maxDim> storage = getCubeEWPStorage<T, maxDim, N>();
+	return storage;
+}
 
 template<class T, int maxDim, int N>
 class PreComputedCubeEigenValues
@@ -495,9 +845,7 @@ public:
 	using scalar = std::complex<real>;
 	using SpaceVec = Uberton::Math::Vector<real, maxDim>;
 
-	PreComputedCubeEigenValues() {
-		storage = getCubeEWPStorage<T, maxDim, N>();
-	}
+	PreComputedCubeEigenValues() : storage(&getSharedCubeEWPStorage<T, maxDim, N>()) {}
 
 	void setDim(int newDim) {
 		if (newDim < 1)
@@ -512,18 +860,38 @@ public:
 	real getLength() const { return length; }
 
 	scalar eigenValueSqrt(int i) const {
-		return storage.matrices[dim - 1].data[i].eigenvalue * pi<real>() / length;
+		return storage->matrices[dim - 1].data[i].eigenvalue * pi<real>() / length;
 	}
 
 	scalar eigenFunction(int i, const SpaceVec& x) const {
 		real result{ 1 };
 		constexpr real pi = Uberton::Math::pi<real>();
 		for (int j = 0; j < dim; ++j) {
-			result *= std::sin(storage.matrices[dim - 1].data[i].coeffs[j] * pi * x[j]); // no division by length as x is normalized
+			result *= std::sin(storage->matrices[dim - 1].data[i].coeffs[j] * pi * x[j]); // no division by length as x is normalized
 		}
 		return result;
 	}
 
+	void eigenFunctions(const SpaceVec& x, scalar* out, int n) const {
+		// one vectorized sine per dimension over all modes
+		constexpr real pi = Uberton::Math::pi<real>();
+		const auto& modes = storage->matrices[dim - 1].data;
+		std::array<real, N> arguments, product;
+		product.fill(1);
+		for (int j = 0; j < dim; ++j) {
+			for (int i = 0; i < n; i++) {
+				arguments[i] = modes[i].coeffs[j] * pi * x[j];
+			}
+			Simd::sin(arguments.data(), arguments.data(), n);
+			for (int i = 0; i < n; i++) {
+				product[i] *= arguments[i];
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			out[i] = product[i];
+		}
+	}
+
 	void setDesiredBaseFrequency(real f, real b, real c) {
 		constexpr real pi = Uberton::Math::pi<real>();
 		const real w = 2 * pi * f;
@@ -531,13 +899,13 @@ public:
 	}
 
 private:
-	CubeEWPStorage<T, maxDim> storage;
+	const CubeEWPStorage<T, maxDim>* storage;
 	real length{ 1 };
 	int dim{ maxDim };
 };
 
-template<class T, int maxDim, int N, int channels>
-class PreComputedCubeResonator : public ResonatorBase<PreComputedCubeEigenValues<T, maxDim, N>, T, maxDim, N, channels>
+template<class T, int maxDim, int N, int channels, int outputChannels = channels>
+class PreComputedCubeResonator : public ResonatorBase<PreComputedCubeEigenValues<T, maxDim, N>, T, maxDim, N, channels, outputChannels>
 {
 };
 
@@ -555,6 +923,22 @@ public:
 	using scalar = std::complex<real>;
 	using SpaceVec = Uberton::Math::Vector<real, 3>;
 
+	SphereEigenValues() {
+		int offset = 0;
+		for (int m = 0; m <= maxL; m++) {
+			columnOffsets[m] = offset;
+			offset += maxL - m + 1;
+		}
+		for (int i = 0; i < N; i++) {
+			auto lm = linearIndex(i);
+			int l = lm.first;
+			int m = -lm.second;
+			// P_l^−m = (−1)ᵐ·(l − m)!/(l + m)!·P_l^m
+			double conversion = m >= 0 ? 1.0 : ((m & 1) ? -1.0 : 1.0) * Uberton::Math::factorial(l + m) / Uberton::Math::factorial(l - m);
+			modeNormalizers[i] = static_cast<real>(std::sqrt(r_twopi<double>()) * normalizer(l, m) * conversion);
+		}
+	}
+
 	scalar eigenValueSqrt(int i) const {
 		int l = linearIndex(i).first;
 		return std::sqrt(l * (l + 1)) * baseFreqCoeff;
@@ -576,6 +960,32 @@ public:
 		return std::pow(r, l) * r_twopi_sqrt * normalizer(l, m) * legend * std::cos(m * phi);
 	}
 
+	// Evaluates all P_l^m(cos θ) for 0 ≤ m ≤ l ≤ maxL with one upward recurrence per order m
+	// and combines them with precomputed normalizers. Negative orders are obtained from the
+	// positive ones, so this is O(n) in total instead of O(n·l).
+	void eigenFunctions(const SpaceVec& x, scalar* out, int n) {
+		const real r = x[0];
+		const real cosPhi = std::cos(x[1]);
+		const real cosTheta = std::cos(x[2]);
+		const real sinTheta = std::sin(x[2]);
+
+		for (int m = 0; m <= maxL; m++) {
+			assoc_legendre_degrees<real>(m, cosTheta, sinTheta, maxL - m + 1, legendre.data() + columnOffsets[m]);
+		}
+		radialPowers[0] = 1;
+		cosines[0] = 1;
+		for (int k = 1; k <= maxL; k++) {
+			radialPowers[k] = radialPowers[k - 1] * r;
+			cosines[k] = k == 1 ? cosPhi : 2 * cosPhi * cosines[k - 1] - cosines[k - 2]; // cos(kφ)
+		}
+		for (int i = 0; i < n; i++) {
+			auto lm = linearIndex(i);
+			int l = lm.first;
+			int m = std::abs(lm.second);
+			out[i] = radialPowers[l] * modeNormalizers[i] * legendre[columnOffsets[m] + l - m] * cosines[m];
+		}
+	}
+
 	void setDesiredBaseFrequency(real f, real b, real c) {
 		baseFreqCoeff = f / std::sqrt(2);
 	}
@@ -597,14 +1007,28 @@ private:
 		return (std::sqrt((real(2) * l + real(1)) / real(2) * Uberton::Math::factorial(l - m) / Uberton::Math::factorial(l + m)));
 	}
 
+	// highest l that occurs for the first N modes
+	static constexpr int computeMaxL() {
+		int l = 0;
+		while ((l + 1) * (l + 1) <= N) l++;
+		return l;
+	}
+	static constexpr int maxL = computeMaxL();
+
 	real baseFreqCoeff{ 1 };
 	static constexpr real pi = Uberton::Math::pi<real>();
 	const real r_twopi_sqrt = std::sqrt(r_twopi<real>());
+
+	array<real, N> modeNormalizers{};							// all factors that only depend on l and m
+	array<int, maxL + 1> columnOffsets{};						// start of the column of order m in legendre
+	array<real, (maxL + 1) * (maxL + 2) / 2> legendre{};		// P_l^m(cos θ) for the current position
+	array<real, maxL + 1> radialPowers{};						// rˡ
+	array<real, maxL + 1> cosines{};							// cos(mφ)
 };
 
 
-template<class T, int N, int channels>
-class SphereResonator : public ResonatorBase<SphereEigenValues<T, N>, T, 3, N, channels>
+template<class T, int N, int channels, int outputChannels = channels>
+class SphereResonator : public ResonatorBase<SphereEigenValues<T, N>, T, 3, N, channels, outputChannels>
 {
 };
 
@@ -613,6 +1037,166 @@ class SphereResonator : public ResonatorBase<SphereEigenValues<T, N>, T, 3, N, c
 // ----         ----------------------------------------------------
 // ---- NSphere ----------------------------------------------------
 // ----         ----------------------------------------------------
+//
+// The quantum number combinations of the first N+1 hyperspherical harmonics only depend
+// on the dimension. They are computed once for every dimension from 2 to maxDim and shared
+// by all NSphereEigenValues instances with the same template parameters. Alongside, all
+// factors of the eigenfunctions that only depend on the quantum numbers are precomputed.
+//
+// For every angle θⱼ the eigenfunctions contain an associated Legendre function P_ν^μ(cos θⱼ)
+// with ν = L + (j − 2)/2 and μ = −(l + (j − 2)/2). Many modes share the same order μ, so
+// for every dimension and angle a "Legendre plan" groups the required functions into
+// columns of equal order which can be evaluated with a single upward recurrence each.
+template<class T, int maxDim, int N>
+struct NSphereCombinationStorage
+{
+	static_assert(maxDim > 1, "template parameter maxDim needs to be greater than 1");
+	static constexpr int numQuantumNumbers = maxDim - 1;
+
+	struct Combination
+	{
+		std::array<int, numQuantumNumbers> coeffs;
+		T eigenValue;
+		T normalizer;										  // 1/√(2π)·∏ⱼ√[(2L + j − 1)(L + l + j − 2)! / (2(L − l)!)]
+		std::array<int, numQuantumNumbers> legendreSlots{}; // index of P_ν^μ(cos θⱼ) in the evaluated plan of angle j
+	};
+	using Combinations = std::array<Combination, N + 1>;
+
+	// P_ν^μ for ν = |μ|, ..., |μ| + count − 1 stored from offset on
+	struct LegendreColumn
+	{
+		T order;
+		int count;
+		int offset;
+	};
+	struct LegendrePlan
+	{
+		std::vector<LegendreColumn> columns;
+		int size{ 0 }; // total number of values
+	};
+	using LegendrePlans = std::array<LegendrePlan, numQuantumNumbers>;
+
+	NSphereCombinationStorage() {
+		for (int dim = 2; dim <= maxDim; dim++) {
+			computeCombinations(dim, combinations[dim - 2]);
+			computeNormalizers(dim, combinations[dim - 2]);
+			computeLegendrePlans(dim, combinations[dim - 2], legendrePlans[dim - 2]);
+		}
+	}
+
+	const Combinations& get(int dim) const { return combinations[dim - 2]; }
+	const LegendrePlans& getLegendrePlans(int dim) const { return legendrePlans[dim - 2]; }
+
+	// Largest plan size over all dimensions and angles (for preallocating the evaluation buffer)
+	int maxLegendrePlanSize() const {
+		int size = 0;
+		for (const auto& plans : legendrePlans)
+			for (const auto& plan : plans)
+				size = std::max(size, plan.size);
+		return size;
+	}
+
+	// Degree ν and order μ of the associated Legendre function for angle θⱼ with L = coeffs[j − 1]
+	// and l = coeffs[j − 2]. μ is an integer for even j and a negative half-integer for odd j.
+	static void legendreDegreeAndOrder(int j, int L, int l, T& nu, T& mu) {
+		const int jj_i = j / 2 - 1;
+		if (j % 2 == 0) {
+			nu = static_cast<T>(L + jj_i);
+			mu = -static_cast<T>(l + jj_i);
+		} else {
+			nu = static_cast<T>(L + jj_i) + T(0.5);
+			mu = -(static_cast<T>(l + jj_i) + T(0.5));
+		}
+	}
+
+private:
+	static void computeCombinations(int dim, Combinations& combinations) {
+		Combination current{};
+		int index = 0; // index that points to one of the quantum numbers of one combination
+		const int lastIndex = dim - 2;
+		int combinationCount = 0;
+		while (combinationCount < N + 1) {
+			if (index != lastIndex && current.coeffs[index] >= current.coeffs[index + 1]) {
+				index++;
+				continue;
+			}
+
+			combinations[combinationCount++] = current;
+			current.coeffs[index]++;
+			if (index == lastIndex) {
+				current.eigenValue = std::sqrt(current.coeffs[index] * (current.coeffs[index] + dim - 2));
+			}
+			if (index != 0) {
+				for (int i = 1; i < index; i++)
+					current.coeffs[i] = 0;
+				current.coeffs[0] = -current.coeffs[1]; // instead set to zero to omit all combinations with negative l_1
+				index--;
+			}
+		}
+	}
+
+	static void computeNormalizers(int dim, Combinations& combinations) {
+		for (auto& combination : combinations) {
+			double normalizer = std::sqrt(r_twopi<double>());
+			for (int j = 2; j <= dim - 1; j++) {
+				int L = combination.coeffs[j - 1]; // l
+				int l = combination.coeffs[j - 2]; // m
+				normalizer *= std::sqrt(((2.0 * L + j - 1) * lookupFactorial(L + l + j - 2)) / (2.0 * lookupFactorial(L - l)));
+				if (j % 2 == 1) {
+					// Sounds have always been tuned with generalized_assoc_legendre_plus_onehalf() which
+					// divides by Γ(5/2 − m) instead of Γ(1/2 − m). Keep this factor so nothing changes.
+					const int jj_i = j / 2 - 1;
+					normalizer /= (l + jj_i + 1.5) * (l + jj_i + 2.5);
+				}
+			}
+			combination.normalizer = static_cast<T>(normalizer);
+		}
+	}
+
+	static void computeLegendrePlans(int dim, Combinations& combinations, LegendrePlans& plans) {
+		for (int j = 2; j <= dim - 1; j++) {
+			// l = coeffs[j − 2] determines the order, so there is one column per occurring l
+			int minL = 0, maxL = 0;
+			for (const auto& combination : combinations) {
+				minL = std::min(minL, combination.coeffs[j - 2]);
+				maxL = std::max(maxL, combination.coeffs[j - 2]);
+			}
+			std::vector<int> counts(maxL - minL + 1, 0);
+			for (const auto& combination : combinations) {
+				T nu, mu;
+				legendreDegreeAndOrder(j, combination.coeffs[j - 1], combination.coeffs[j - 2], nu, mu);
+				int& count = counts[combination.coeffs[j - 2] - minL];
+				count = std::max(count, static_cast<int>(nu - std::abs(mu) + T(0.5)) + 1);
+			}
+
+			auto& plan = plans[j - 2];
+			std::vector<int> offsets(counts.size(), 0);
+			for (int k = 0; k < static_cast<int>(counts.size()); k++) {
+				if (counts[k] == 0) continue;
+				T nu, mu;
+				legendreDegreeAndOrder(j, 0, k + minL, nu, mu);
+				offsets[k] = plan.size;
+				plan.columns.push_back({ mu, counts[k], plan.size });
+				plan.size += counts[k];
+			}
+			for (auto& combination : combinations) {
+				T nu, mu;
+				legendreDegreeAndOrder(j, combination.coeffs[j - 1], combination.coeffs[j - 2], nu, mu);
+				combination.legendreSlots[j - 2] = offsets[combination.coeffs[j - 2] - minL] + static_cast<int>(nu - std::abs(mu) + T(0.5));
+			}
+		}
+	}
+
+	std::array<Combinations, maxDim - 1> combinations;
+	std::array<LegendrePlans, maxDim - 1> legendrePlans;
+};
+
+template<class T, int maxDim, int N>
+const NSphereCombinationStorage<T, maxDim, N>& getNSphereCombinationStorage() {
+	static const NSphereCombinationStorage<T, maxDim, N> storage;
+	return storage;
+}
+
 //
 // Allowed dimensions: d >= 2
 // Input/output coordinate values need to have the following format:
@@ -628,11 +1212,14 @@ public:
 	using real = T;
 	using scalar = std::complex<real>;
 	using SpaceVec = Uberton::Math::Vector<T, maxDim>;
+	using Storage = NSphereCombinationStorage<T, maxDim, N>;
 
-	NSphereEigenValues() {
-		computeCombinations(dim);
+	NSphereEigenValues() : storage(&getNSphereCombinationStorage<T, maxDim, N>()) {
+		combinations = &storage->get(dim);
+		legendre.resize(storage->maxLegendrePlanSize());
 	}
 
+	// Switching the dimension is O(1) as all combinations are precomputed
 	void setDim(int newDim) {
 		if (newDim == dim) return;
 		if (newDim < 2)
@@ -641,57 +1228,82 @@ public:
 			dim = maxDim;
 		else
 			dim = newDim;
-		computeCombinations(dim);
+		combinations = &storage->get(dim);
 	}
 
 	int getDim() const { return dim; }
 
 	scalar eigenValueSqrt(int i) const {
-		return combinations[i+1].eigenValue * radius_inv; // λ = −l(l + d − 2)/r²
+		return (*combinations)[i + 1].eigenValue * radius_inv; // λ = −l(l + d − 2)/r²
 	}
 
-	// It's worth to use lookup factorial and gamma_plus_half.
 	scalar eigenFunction(int i, const SpaceVec& x) const {
 		// https://en.wikipedia.org/wiki/Spherical_harmonics#Higher_dimensions
 		using namespace std;
 
-		const auto& combination = combinations[i+1];
+		const auto& combination = (*combinations)[i + 1];
 
-		real factor = r_twopi_sqrt;
 		real r = x[0];
 		real phase = combination.coeffs[0] * x[1];
 		scalar phase_factor = cos(phase) + scalar(0, 1) * sin(phase);
-		scalar product{ 1 };
+		real product{ 1 };
 		for (int j = 2; j <= dim - 1; j++) {
 			int L = combination.coeffs[j - 1]; // l
 			int l = combination.coeffs[j - 2]; // m
 			real theta_j = x[j];
 
-			int jj_i = static_cast<int>(std::floor(j * real(0.5))) - 1; // j / 2 - 1;
 			real jj = (j - real(2)) * real(0.5);
 
-			scalar p1 = sqrt(((real(2) * L + j - 1) * lookupFactorial(L + l + j - real(2))) / (real(2) * lookupFactorial(L - l)));
-			scalar p2 = j == 2 ? 1 : pow(sin(theta_j), -jj);
-			scalar p3;
+			real p2 = j == 2 ? 1 : pow(sin(theta_j), -jj);
 
-			if (j % 2 == 0) { // if j is even, then jj is an integer -> we can use integer associated legendre
-				p3 = Uberton::Math::assoc_legendre<real>(L + jj_i, -(l + jj_i), cos(theta_j));
-				//std::cout << "l2 " << p3 << " " << L << " " << -l << " " << theta_j << "\n";
-			} else {
-				//product *= Uberton::Math::generalized_assoc_legendre<real>(-(l + jj), L + jj, cos(theta_j));
+			// for even j, jj is an integer and for odd j a half-integer; both are handled by the same recurrence
+			real nu, mu;
+			Storage::legendreDegreeAndOrder(j, L, l, nu, mu);
+			real p3 = Uberton::Math::assoc_legendre_general<real>(nu, mu, cos(theta_j), sin(theta_j));
+			product *= p2 * p3;
+		}
+		real ln = combination.coeffs[dim - 2];
+		return (std::pow(r, ln) * combination.normalizer * phase_factor * product).real();
+	}
 
-				// better use fast version:
-				//	let l,L=0, j=3 ⇒ jj = 1/2, jj_i = 0
-				//	compute p(-1/2, 1/2)
-				//	p(-jj_i - 1, jj_i) = p_plus_1/2(-1,0) = p(-.5, .5)
-				p3 = Uberton::Math::generalized_assoc_legendre_plus_onehalf<real>(L + jj_i, -(l + jj_i + 1), cos(theta_j));
-			}
-			product *= p1 * p2 * p3;
+	// Evaluates the first n eigenfunctions at once. All Legendre functions of one angle are computed
+	// column-wise according to the precomputed plan and the factors that only depend on the position
+	// (sin θⱼ^−(j−2)/2, rˡ and cos(lφ)) are computed only once.
+	void eigenFunctions(const SpaceVec& x, scalar* out, int n) {
+		const auto& combs = *combinations;
+		const auto& plans = storage->getLegendrePlans(dim);
 
-			// (j-1)/2 = j/2 - 1 = [j/2] - 1 + 1/2
+		real sinePowers{ 1 };
+		for (int j = 3; j <= dim - 1; j++) {
+			sinePowers *= std::pow(std::sin(x[j]), -(j - real(2)) * real(0.5));
+		}
+
+		const real r = x[0];
+		const real cosPhi = std::cos(x[1]);
+		radialPowers[0] = 1;
+		cosines[0] = 1;
+		for (int k = 1; k <= N; k++) {
+			radialPowers[k] = radialPowers[k - 1] * r;
+			cosines[k] = k == 1 ? cosPhi : 2 * cosPhi * cosines[k - 1] - cosines[k - 2]; // cos(kφ)
+		}
+
+		for (int i = 0; i < n; i++) {
+			const auto& combination = combs[i + 1];
+			values[i] = radialPowers[combination.coeffs[dim - 2]] * cosines[std::abs(combination.coeffs[0])] * combination.normalizer * sinePowers;
+		}
+		for (int j = 2; j <= dim - 1; j++) {
+			const real cosTheta = std::cos(x[j]);
+			const real sinTheta = std::sin(x[j]);
+			for (const auto& column : plans[j - 2].columns) {
+				Uberton::Math::assoc_legendre_degrees<real>(column.order, cosTheta, sinTheta, column.count, legendre.data() + column.offset);
+			}
+			for (int i = 0; i < n; i++) {
+				values[i] *= legendre[combs[i + 1].legendreSlots[j - 2]];
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			out[i] = values[i];
 		}
-		real ln = combination.coeffs[dim - 2];
-		return (std::pow(r, ln) * factor * phase_factor * product).real();
 	}
 
 	void setDesiredBaseFrequency(real f, real b, real c) {
@@ -710,33 +1322,8 @@ public:
 	}
 
 private:
-	void computeCombinations(int dim) {
-		Combination current{};
-		int index = 0; // index that points to one of the quantum numbers of one combination
-		const int lastIndex = dim - 2;
-		int combinationCount = 0;
-		while (combinationCount < N+1) {
-			if (index != lastIndex && current.coeffs[index] >= current.coeffs[index + 1]) {
-				index++;
-				continue;
-			}
-
-			combinations[combinationCount++] = current;
-			current.coeffs[index]++;
-			if (index == lastIndex) {
-				current.eigenValue = std::sqrt(current.coeffs[index] * (current.coeffs[index] + dim - 2));
-			}
-			if (index != 0) {
-				for (int i = 1; i < index; i++)
-					current.coeffs[i] = 0;
-				current.coeffs[0] = -current.coeffs[1]; // instead set to zero to omit all combinations with negative l_1
-				index--;
-			}
-		}
-		//printCombinations();
-	}
 	void printCombinations() const {
-		for (const auto& combination : combinations) {
+		for (const auto& combination : *combinations) {
 			for (int t : combination.coeffs) {
 				std::cout << t << ' ';
 			}
@@ -746,22 +1333,22 @@ private:
 
 	int dim{ maxDim };
 	static constexpr real pi = Uberton::Math::pi<real>();
-	const real r_twopi_sqrt = std::sqrt(r_twopi<real>());
-	static constexpr int numQuantumNumbers = maxDim - 1;
-	struct Combination
-	{
-		std::array<int, numQuantumNumbers> coeffs;
-		T eigenValue;
-	};
 
-	std::array<Combination, N+1> combinations;
+	const Storage* storage;
+	const typename Storage::Combinations* combinations{ nullptr };
 
 	real radius_inv{ 1 };
+
+	// scratch buffers for eigenFunctions()
+	std::vector<real> legendre;
+	array<real, N> values{};
+	array<real, N + 1> radialPowers{};
+	array<real, N + 1> cosines{};
 };
 
 
-template<class T, int maxDim, int N, int channels>
-class NSphereResonator : public ResonatorBase<NSphereEigenValues<T, maxDim, N>, T, maxDim, N, channels>
+template<class T, int maxDim, int N, int channels, int outputChannels = channels>
+class NSphereResonator : public ResonatorBase<NSphereEigenValues<T, maxDim, N>, T, maxDim, N, channels, outputChannels>
 {
 };
 
@@ -0,0 +1,200 @@
+// Polyphonic resonator voices in SIMD lanes
+//  - one voice per lane, mode i of all voices of a group shares a vector
+//  - block rendering of 4, 8 or 16 voices with one instruction stream
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "resonator.h"
+#include "simd.h"
+#include <algorithm>
+#include <array>
+
+namespace Uberton {
+namespace Math {
+
+//
+// A group of numLanes voices of the same resonator type. Instruments typically use resonators
+// with only a few modes per voice, which is too short to fill a vector. Here the state of mode i
+// of all voices (the amplitude, the time step and the output weight, see ResonatorBase) is
+// stored side by side, so that one complex multiply on a vector evolves mode i of the whole
+// group:
+//
+//   a[i][lane] ← a[i][lane]·timeFunctions[i][lane]
+//   out        += Σ_lane Re(a[i][lane]·w[i][lane])
+//
+// The time steps and weights are computed with a Resonator instance (for the eigenvalues and
+// eigenfunctions of StringEigenValues, CubeEigenValues, ...) and copied into a lane. Lanes of
+// voices that are not playing should be cleared. Rendering a group costs about the same as one
+// voice of the scalar resonator, independent of how many of its lanes are sounding.
+//
+// Usage:
+//   resonator.setFreqDampeningAndVelocity(f, b, c);
+//   group.setTimeFunctions(lane, resonator.timeFunctions.data());
+//   group.setOutputWeights(lane, resonator.outputPosEF[0].data());
+//   group.excite(lane, excitation.data());
+//   group.render(out, numSamples); // adds the sum of all lanes to out
+//
+template<class Resonator, int numLanes>
+class ResonatorVoiceGroup
+{
+public:
+	using real = typename Resonator::real;
+	using scalar = typename Resonator::scalar;
+	using Vec = Simd::Vec<real>;
+
+	static constexpr int N = Resonator::maxOrder();
+	static constexpr int numRegisters = numLanes / Vec::size;
+	static_assert(numLanes % Vec::size == 0, "numLanes needs to be a multiple of the vector size");
+
+	static constexpr int lanes() { return numLanes; }
+
+	void setTimeFunctions(int lane, const scalar* timeFunctions) {
+		for (int i = 0; i < N; i++) {
+			tfRe[i][lane] = timeFunctions[i].real();
+			tfIm[i][lane] = timeFunctions[i].imag();
+		}
+	}
+
+	void setOutputWeights(int lane, const scalar* weights) {
+		for (int i = 0; i < N; i++) {
+			wRe[i][lane] = weights[i].real();
+			wIm[i][lane] = weights[i].imag();
+		}
+	}
+
+	/// Add a delta peak with the given weights (amount · input eigenfunctions) to the amplitudes
+	void excite(int lane, const scalar* weights) {
+		for (int i = 0; i < N; i++) {
+			aRe[i][lane] += weights[i].real();
+			aIm[i][lane] += weights[i].imag();
+		}
+	}
+
+	/// Multiply the time steps with a factor < 1 for additional dampening (i.e. on note off)
+	void dampen(int lane, real factor) {
+		for (int i = 0; i < N; i++) {
+			tfRe[i][lane] *= factor;
+			tfIm[i][lane] *= factor;
+		}
+	}
+
+	/// Set the amplitudes of the lane to zero
+	void clear(int lane) {
+		for (int i = 0; i < N; i++) {
+			aRe[i][lane] = 0;
+			aIm[i][lane] = 0;
+		}
+	}
+
+	void clear() {
+		for (int i = 0; i < N; i++) {
+			aRe[i].fill(0);
+			aIm[i].fill(0);
+		}
+	}
+
+	/// Σ|a|² of the lane
+	real energy(int lane) const {
+		real e = 0;
+		for (int i = 0; i < N; i++) {
+			e += aRe[i][lane] * aRe[i][lane] + aIm[i][lane] * aIm[i][lane];
+		}
+		return e;
+	}
+
+	/// Evolve all lanes for numSamples samples and add the sum of their outputs to out. The
+	/// modes are processed one after another (like ResonatorBase::processBlock()), the lanes are
+	/// summed into one vector per sample and reduced once per sample at the end of a sub-block.
+	void render(real* out, int numSamples) {
+		std::array<Vec, subBlockSize> y;
+		for (int blockStart = 0; blockStart < numSamples; blockStart += subBlockSize) {
+			const int blockSize = std::min(subBlockSize, numSamples - blockStart);
+			std::fill(y.begin(), y.begin() + blockSize, Vec(real(0)));
+
+			for (int first = 0; first < N; first += modesPerPass) {
+				renderModes<std::min(modesPerPass, N)>(first, y.data(), blockSize);
+			}
+
+			for (int s = 0; s < blockSize; s++) {
+				real values[Vec::size];
+				y[s].store(values);
+				real sum = 0;
+				for (int k = 0; k < Vec::size; k++) {
+					sum += values[k];
+				}
+				out[blockStart + s] += sum;
+			}
+		}
+	}
+
+private:
+	static constexpr int subBlockSize = 64;
+	// Each mode is a dependency chain over the samples. Several modes per pass (i.e. several
+	// independent chains per sample) keep the multipliers busy while staying in registers.
+	static constexpr int modesPerPass = std::max(1, 4 / numRegisters);
+
+	// Evolve the modes first ... first + numModes - 1 (clamped to N) and add their output to y
+	template<int numModes>
+	void renderModes(int first, Vec* y, int blockSize) {
+		const int count = std::min(numModes, N - first);
+		if (count < numModes) {
+			if constexpr (numModes > 1) renderModes<numModes - 1>(first, y, blockSize);
+			return;
+		}
+		constexpr int n = numModes * numRegisters;
+		Vec re[n], im[n], tr[n], ti[n], wr[n], wi[n];
+		for (int k = 0; k < n; k++) {
+			const int i = first + k / numRegisters;
+			const int offset = (k % numRegisters) * Vec::size;
+			re[k] = Vec::load(aRe[i].data() + offset);
+			im[k] = Vec::load(aIm[i].data() + offset);
+			tr[k] = Vec::load(tfRe[i].data() + offset);
+			ti[k] = Vec::load(tfIm[i].data() + offset);
+			wr[k] = Vec::load(wRe[i].data() + offset);
+			wi[k] = Vec::load(wIm[i].data() + offset);
+		}
+		for (int s = 0; s < blockSize; s++) {
+			Vec contribution[n];
+			for (int k = 0; k < n; k++) {
+				const Vec newRe = re[k] * tr[k] - im[k] * ti[k];
+				im[k] = re[k] * ti[k] + im[k] * tr[k];
+				re[k] = newRe;
+				contribution[k] = re[k] * wr[k] - im[k] * wi[k];
+			}
+			// pairwise sum, a running sum would be another serial chain
+			for (int stride = 1; stride < n; stride *= 2) {
+				for (int k = 0; k + stride < n; k += 2 * stride) {
+					contribution[k] = contribution[k] + contribution[k + stride];
+				}
+			}
+			y[s] = y[s] + contribution[0];
+		}
+		for (int k = 0; k < n; k++) {
+			const int i = first + k / numRegisters;
+			const int offset = (k % numRegisters) * Vec::size;
+			re[k].store(aRe[i].data() + offset);
+			im[k].store(aIm[i].data() + offset);
+		}
+	}
+
+	using Lanes = std::array<real, numLanes>;
+
+	// mode-major: [mode][lane]
+	std::array<Lanes, N> aRe{}, aIm{};	 // amplitudes
+	std::array<Lanes, N> tfRe{}, tfIm{}; // time steps per sample
+	std::array<Lanes, N> wRe{}, wIm{};	 // output weights
+};
+
+} // namespace Math
+} // namespace Uberton
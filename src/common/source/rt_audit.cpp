@@ -0,0 +1,412 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include "rt_audit.h"
+
+#ifdef UBERTON_RT_AUDIT
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define UBERTON_RT_AUDIT_LIBC
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// the allocator behind malloc(), the replacements below forward to it
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+#elif defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+#elif __has_include(<execinfo.h>)
+#include <execinfo.h>
+#endif
+
+#if defined(__GNUC__)
+// static TLS: reading the flags from inside malloc() must not allocate
+#define UBERTON_RT_AUDIT_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define UBERTON_RT_AUDIT_TLS
+#endif
+
+
+namespace Uberton {
+namespace RTAudit {
+
+namespace {
+
+UBERTON_RT_AUDIT_TLS thread_local int audioThreadDepth = 0;
+UBERTON_RT_AUDIT_TLS thread_local bool reporting = false; // the report itself allocates and locks
+
+constexpr int maxStackDepth = 32;
+constexpr int maxCallSites = 1024;
+
+#ifdef UBERTON_RT_AUDIT_LIBC
+//
+// The next definitions of the intercepted libc functions (the ones the interceptors below forward
+// to). They are resolved when the module is loaded, so that forwarding never calls dlsym() on the
+// audio thread.
+//
+struct LibcFunctions
+{
+	decltype(&::pthread_mutex_lock) pthread_mutex_lock;
+	decltype(&::nanosleep) nanosleep;
+	decltype(&::clock_nanosleep) clock_nanosleep;
+	decltype(&::usleep) usleep;
+	decltype(&::sleep) sleep;
+	decltype(&::read) read;
+	decltype(&::write) write;
+	std::atomic<bool> resolved;
+
+	void resolve() {
+		pthread_mutex_lock = lookup<decltype(pthread_mutex_lock)>("pthread_mutex_lock");
+		nanosleep = lookup<decltype(nanosleep)>("nanosleep");
+		clock_nanosleep = lookup<decltype(clock_nanosleep)>("clock_nanosleep");
+		usleep = lookup<decltype(usleep)>("usleep");
+		sleep = lookup<decltype(sleep)>("sleep");
+		read = lookup<decltype(read)>("read");
+		write = lookup<decltype(write)>("write");
+		resolved.store(true, std::memory_order_release);
+	}
+
+	template<class F>
+	static F lookup(const char* function) { return reinterpret_cast<F>(dlsym(RTLD_NEXT, function)); }
+};
+
+LibcFunctions libcFunctions; // zero-initialized before any constructor runs
+
+const LibcFunctions& libc() {
+	// only calls from constructors that run before the one of the report find it unresolved
+	if (!libcFunctions.resolved.load(std::memory_order_acquire)) libcFunctions.resolve();
+	return libcFunctions;
+}
+
+#endif
+
+const char* name(Violation violation) {
+	switch (violation) {
+	case Violation::Allocation: return "allocation";
+	case Violation::Deallocation: return "deallocation";
+	case Violation::Lock: return "lock";
+	case Violation::BlockingCall: return "blocking call";
+	}
+	return "";
+}
+
+//
+// Violations are counted every time, but the stack trace is only written for the first violation
+// at each call site (identified by a hash of the return addresses), as a violation in process()
+// repeats with every block.
+//
+class Report
+{
+public:
+	Report() {
+#ifdef UBERTON_RT_AUDIT_LIBC
+		libcFunctions.resolve();
+#endif
+		void* frames[1];
+		captureStack(frames, 1); // the first backtrace() loads the unwinder, which allocates
+	}
+
+	~Report() {
+		std::lock_guard<std::mutex> lock(mutex);
+		reporting = true;
+		if (FILE* f = file()) {
+			std::fprintf(f, "[rt audit] %lu violations at %d call sites\n", violations.load(), numCallSites);
+			std::fflush(f);
+			if (f != stderr) std::fclose(f);
+		}
+	}
+
+	void add(Violation violation, const char* function) {
+		violations++;
+		void* frames[maxStackDepth];
+		const int depth = captureStack(frames, maxStackDepth);
+		const uint64_t site = hash(frames, depth);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!insertCallSite(site)) return;
+		FILE* f = file();
+		if (!f) return;
+		std::fprintf(f, "[rt audit] %s on the audio thread: %s\n", name(violation), function);
+		writeStack(f, frames, depth);
+		std::fprintf(f, "\n");
+		std::fflush(f);
+	}
+
+	unsigned long numViolations() const { return violations.load(); }
+
+private:
+	FILE* file() {
+		if (!output) {
+			const char* path = std::getenv("UBERTON_RT_AUDIT_REPORT");
+			output = path ? std::fopen(path, "a") : nullptr;
+			if (!output) output = stderr;
+		}
+		return output;
+	}
+
+	static int captureStack(void** frames, int maxFrames) {
+#if defined(_WIN32)
+		return CaptureStackBackTrace(0, maxFrames, frames, nullptr);
+#elif defined(UBERTON_RT_AUDIT_LIBC) || __has_include(<execinfo.h>)
+		return backtrace(frames, maxFrames);
+#else
+		return 0;
+#endif
+	}
+
+	static void writeStack(FILE* f, void* const* frames, int depth) {
+#if !defined(_WIN32) && (defined(UBERTON_RT_AUDIT_LIBC) || __has_include(<execinfo.h>))
+		std::fflush(f);
+		backtrace_symbols_fd(frames, depth, fileno(f));
+#else
+		for (int i = 0; i < depth; i++) {
+			std::fprintf(f, "  %p\n", frames[i]);
+		}
+#endif
+	}
+
+	static uint64_t hash(void* const* frames, int depth) {
+		uint64_t h = 14695981039346656037ull; // FNV-1a
+		for (int i = 0; i < depth; i++) {
+			h = (h ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+		}
+		return h | 1; // 0 marks an empty slot
+	}
+
+	// Returns false if the call site has been reported before (mutex needs to be held)
+	bool insertCallSite(uint64_t site) {
+		for (int i = 0; i < maxCallSites; i++) {
+			uint64_t& slot = callSites[(site + i) % maxCallSites];
+			if (slot == site) return false;
+			if (slot == 0) {
+				slot = site;
+				numCallSites++;
+				return true;
+			}
+		}
+		return false; // full, the summary still counts the violation
+	}
+
+	std::mutex mutex;
+	FILE* output{ nullptr };
+	std::atomic<unsigned long> violations{ 0 };
+	uint64_t callSites[maxCallSites]{};
+	int numCallSites{ 0 };
+};
+
+Report& report() {
+	static Report instance;
+	return instance;
+}
+
+// constructed before main() / when the module is loaded, not on the audio thread
+const Report& reportInstance = report();
+
+} // namespace
+
+
+AudioThreadScope::AudioThreadScope() { audioThreadDepth++; }
+AudioThreadScope::~AudioThreadScope() { audioThreadDepth--; }
+
+bool isAudioThread() { return audioThreadDepth > 0; }
+
+void check(Violation violation, const char* function) {
+	if (audioThreadDepth == 0 || reporting) return;
+	reporting = true;
+	report().add(violation, function);
+	reporting = false;
+}
+
+unsigned long numViolations() { return report().numViolations(); }
+
+} // namespace RTAudit
+} // namespace Uberton
+
+
+// --- Interceptors ------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+using Uberton::RTAudit::check;
+using Uberton::RTAudit::Violation;
+
+void* rawMalloc(std::size_t size) {
+#ifdef UBERTON_RT_AUDIT_LIBC
+	return __libc_malloc(size);
+#else
+	return std::malloc(size);
+#endif
+}
+
+void rawFree(void* ptr) {
+#ifdef UBERTON_RT_AUDIT_LIBC
+	__libc_free(ptr);
+#else
+	std::free(ptr);
+#endif
+}
+
+void* rawAlignedMalloc(std::size_t size, std::size_t alignment) {
+#if defined(UBERTON_RT_AUDIT_LIBC)
+	return __libc_memalign(alignment, size);
+#elif defined(_WIN32)
+	return _aligned_malloc(size, alignment);
+#else
+	void* ptr = nullptr;
+	return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+void rawAlignedFree(void* ptr) {
+#if defined(_WIN32) && !defined(UBERTON_RT_AUDIT_LIBC)
+	_aligned_free(ptr);
+#else
+	rawFree(ptr);
+#endif
+}
+
+void* allocate(std::size_t size, const char* function) {
+	check(Violation::Allocation, function);
+	void* ptr = rawMalloc(size ? size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment, const char* function) {
+	check(Violation::Allocation, function);
+	void* ptr = rawAlignedMalloc(size ? size : 1, static_cast<std::size_t>(alignment));
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void deallocate(void* ptr, const char* function) {
+	if (!ptr) return;
+	check(Violation::Deallocation, function);
+	rawFree(ptr);
+}
+
+void deallocateAligned(void* ptr, const char* function) {
+	if (!ptr) return;
+	check(Violation::Deallocation, function);
+	rawAlignedFree(ptr);
+}
+
+} // namespace
+
+
+void* operator new(std::size_t size) { return allocate(size, "operator new"); }
+void* operator new[](std::size_t size) { return allocate(size, "operator new[]"); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	check(Violation::Allocation, "operator new");
+	return rawMalloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	check(Violation::Allocation, "operator new[]");
+	return rawMalloc(size ? size : 1);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment, "operator new"); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment, "operator new[]"); }
+
+void operator delete(void* ptr) noexcept { deallocate(ptr, "operator delete"); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::size_t) noexcept { deallocate(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::size_t) noexcept { deallocate(ptr, "operator delete[]"); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr, "operator delete"); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::align_val_t) noexcept { deallocateAligned(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { deallocateAligned(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { deallocateAligned(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { deallocateAligned(ptr, "operator delete[]"); }
+
+
+#ifdef UBERTON_RT_AUDIT_LIBC
+
+// Forward the call to the next definition of the function
+#define UBERTON_RT_AUDIT_FORWARD(function, ...) return Uberton::RTAudit::libc().function(__VA_ARGS__)
+
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+	check(Violation::Allocation, "malloc");
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+	check(Violation::Allocation, "calloc");
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+	check(Violation::Allocation, "realloc");
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept {
+	if (ptr) check(Violation::Deallocation, "free");
+	__libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+	check(Violation::Lock, "pthread_mutex_lock");
+	UBERTON_RT_AUDIT_FORWARD(pthread_mutex_lock, mutex);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+	check(Violation::BlockingCall, "nanosleep");
+	UBERTON_RT_AUDIT_FORWARD(nanosleep, duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec* time, struct timespec* remaining) {
+	check(Violation::BlockingCall, "clock_nanosleep");
+	UBERTON_RT_AUDIT_FORWARD(clock_nanosleep, clock, flags, time, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+	check(Violation::BlockingCall, "usleep");
+	UBERTON_RT_AUDIT_FORWARD(usleep, microseconds);
+}
+
+unsigned int sleep(unsigned int seconds) {
+	check(Violation::BlockingCall, "sleep");
+	UBERTON_RT_AUDIT_FORWARD(sleep, seconds);
+}
+
+ssize_t read(int fd, void* buffer, size_t size) {
+	check(Violation::BlockingCall, "read");
+	UBERTON_RT_AUDIT_FORWARD(read, fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size) {
+	check(Violation::BlockingCall, "write");
+	UBERTON_RT_AUDIT_FORWARD(write, fd, buffer, size);
+}
+
+} // extern "C"
+
+#endif // UBERTON_RT_AUDIT_LIBC
+
+#endif // UBERTON_RT_AUDIT
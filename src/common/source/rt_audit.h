@@ -0,0 +1,81 @@
+// Real-time safety audit of the audio thread
+//  - ProcessorBase::process() marks the audio thread for the duration of the call
+//  - with UBERTON_RT_AUDIT, allocations, mutex locks and blocking calls on the marked thread are
+//    reported with a stack trace
+//  - compiles to nothing otherwise
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+namespace Uberton {
+namespace RTAudit {
+
+//
+// Code that runs inside process() must not allocate, lock or wait, which is easy to break without
+// noticing (a resize() on a rarely taken path, a heap object released by the state transfer, ...).
+// The audit build (CMake option UBERTON_RT_AUDIT) replaces the global allocation functions and on
+// Linux also malloc()/free(), pthread_mutex_lock() and the sleeping and file I/O calls. While a
+// thread is inside an AudioThreadScope, each call is reported once per call site with a stack
+// trace to the file in the environment variable UBERTON_RT_AUDIT_REPORT (or stderr). A summary
+// with the number of violations is appended when the module is unloaded.
+//
+// Running a host or the validator with an audit build (and automating the parameters) then lists
+// every real-time violation of the plugin. Without a host, the test <Plugin>_rt_audit (run by
+// ctest) sweeps all parameters of each processor of the plugin and fails on any violation.
+//
+// On Linux the plugins are linked with -Bsymbolic in the audit build, so that the plugin's own
+// calls bind to the replacements even if the host has loaded the allocator before. On other
+// platforms only new/delete are audited.
+//
+// Usage:
+//   tresult PLUGIN_API process(ProcessData& data) {
+//     UBERTON_RT_AUDIT_SCOPE;
+//     ...
+//
+enum class Violation {
+	Allocation,
+	Deallocation,
+	Lock,
+	BlockingCall
+};
+
+#ifdef UBERTON_RT_AUDIT
+
+// Marks the current thread as audio thread while in scope (scopes may be nested)
+class AudioThreadScope
+{
+public:
+	AudioThreadScope();
+	~AudioThreadScope();
+	AudioThreadScope(const AudioThreadScope&) = delete;
+	AudioThreadScope& operator=(const AudioThreadScope&) = delete;
+};
+
+bool isAudioThread();
+
+// Record a violation if the current thread is marked (called by the interceptors)
+void check(Violation violation, const char* function);
+
+// Total number of violations so far
+unsigned long numViolations();
+
+#define UBERTON_RT_AUDIT_SCOPE ::Uberton::RTAudit::AudioThreadScope rtAuditScope_
+
+#else
+
+#define UBERTON_RT_AUDIT_SCOPE
+
+#endif
+
+} // namespace RTAudit
+} // namespace Uberton
@@ -0,0 +1,290 @@
+// Thin wrapper around SIMD registers for float and double
+//  - SSE2 (x86/x64), NEON (AArch64) or a scalar fallback
+//  - Vec<float> holds 4 floats (1 in the fallback), Vec<double> 2 doubles (1 in the fallback)
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if !defined(UBERTON_SIMD_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define UBERTON_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif !defined(UBERTON_SIMD_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#define UBERTON_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define UBERTON_SIMD_FALLBACK 1
+#endif
+
+namespace Uberton {
+namespace Simd {
+
+//
+// Vec<T> supports
+//   - loading/storing (unaligned) and broadcasting: Vec::load(p), v.store(p), Vec(x)
+//   - arithmetic: + - * /, min, max, abs
+//   - comparisons returning lane masks (all bits set or zero) and bitwise operations on them:
+//     <, >, <=, ==, &, |, ^, andnot(a, b) = ~a & b, select(mask, a, b)
+//   - roundNearest(v): round to nearest integer (|v| < 2²² for float, |v| < 2⁵¹ for double)
+//   - pow2i(n): 2ⁿ for integer valued n in the normal range
+//
+template<class T>
+struct Vec;
+
+
+#if defined(UBERTON_SIMD_SSE2)
+
+template<>
+struct Vec<float>
+{
+	static constexpr int size = 4;
+	__m128 v;
+
+	Vec() = default;
+	Vec(__m128 v) : v(v) {}
+	Vec(float x) : v(_mm_set1_ps(x)) {}
+
+	static Vec load(const float* p) { return _mm_loadu_ps(p); }
+	void store(float* p) const { _mm_storeu_ps(p, v); }
+
+	friend Vec operator+(Vec a, Vec b) { return _mm_add_ps(a.v, b.v); }
+	friend Vec operator-(Vec a, Vec b) { return _mm_sub_ps(a.v, b.v); }
+	friend Vec operator*(Vec a, Vec b) { return _mm_mul_ps(a.v, b.v); }
+	friend Vec operator/(Vec a, Vec b) { return _mm_div_ps(a.v, b.v); }
+	friend Vec operator<(Vec a, Vec b) { return _mm_cmplt_ps(a.v, b.v); }
+	friend Vec operator>(Vec a, Vec b) { return _mm_cmpgt_ps(a.v, b.v); }
+	friend Vec operator<=(Vec a, Vec b) { return _mm_cmple_ps(a.v, b.v); }
+	friend Vec operator==(Vec a, Vec b) { return _mm_cmpeq_ps(a.v, b.v); }
+	friend Vec operator&(Vec a, Vec b) { return _mm_and_ps(a.v, b.v); }
+	friend Vec operator|(Vec a, Vec b) { return _mm_or_ps(a.v, b.v); }
+	friend Vec operator^(Vec a, Vec b) { return _mm_xor_ps(a.v, b.v); }
+	friend Vec andnot(Vec a, Vec b) { return _mm_andnot_ps(a.v, b.v); }
+	friend Vec min(Vec a, Vec b) { return _mm_min_ps(a.v, b.v); }
+	friend Vec max(Vec a, Vec b) { return _mm_max_ps(a.v, b.v); }
+
+	static Vec pow2i(Vec n) {
+		const __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+		return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+	}
+};
+
+template<>
+struct Vec<double>
+{
+	static constexpr int size = 2;
+	__m128d v;
+
+	Vec() = default;
+	Vec(__m128d v) : v(v) {}
+	Vec(double x) : v(_mm_set1_pd(x)) {}
+
+	static Vec load(const double* p) { return _mm_loadu_pd(p); }
+	void store(double* p) const { _mm_storeu_pd(p, v); }
+
+	friend Vec operator+(Vec a, Vec b) { return _mm_add_pd(a.v, b.v); }
+	friend Vec operator-(Vec a, Vec b) { return _mm_sub_pd(a.v, b.v); }
+	friend Vec operator*(Vec a, Vec b) { return _mm_mul_pd(a.v, b.v); }
+	friend Vec operator/(Vec a, Vec b) { return _mm_div_pd(a.v, b.v); }
+	friend Vec operator<(Vec a, Vec b) { return _mm_cmplt_pd(a.v, b.v); }
+	friend Vec operator>(Vec a, Vec b) { return _mm_cmpgt_pd(a.v, b.v); }
+	friend Vec operator<=(Vec a, Vec b) { return _mm_cmple_pd(a.v, b.v); }
+	friend Vec operator==(Vec a, Vec b) { return _mm_cmpeq_pd(a.v, b.v); }
+	friend Vec operator&(Vec a, Vec b) { return _mm_and_pd(a.v, b.v); }
+	friend Vec operator|(Vec a, Vec b) { return _mm_or_pd(a.v, b.v); }
+	friend Vec operator^(Vec a, Vec b) { return _mm_xor_pd(a.v, b.v); }
+	friend Vec andnot(Vec a, Vec b) { return _mm_andnot_pd(a.v, b.v); }
+	friend Vec min(Vec a, Vec b) { return _mm_min_pd(a.v, b.v); }
+	friend Vec max(Vec a, Vec b) { return _mm_max_pd(a.v, b.v); }
+
+	static Vec pow2i(Vec n) {
+		// the low mantissa bits of n + 1.5·2⁵² hold n as integer
+		const __m128i bits = _mm_castpd_si128(_mm_add_pd(n.v, _mm_set1_pd(6755399441055744.0)));
+		const __m128i e = _mm_add_epi64(bits, _mm_set1_epi64x(1023));
+		return _mm_castsi128_pd(_mm_slli_epi64(e, 52));
+	}
+};
+
+
+#elif defined(UBERTON_SIMD_NEON)
+
+template<>
+struct Vec<float>
+{
+	static constexpr int size = 4;
+	float32x4_t v;
+
+	Vec() = default;
+	Vec(float32x4_t v) : v(v) {}
+	Vec(float x) : v(vdupq_n_f32(x)) {}
+
+	static Vec load(const float* p) { return vld1q_f32(p); }
+	void store(float* p) const { vst1q_f32(p, v); }
+
+	static Vec fromBits(uint32x4_t b) { return vreinterpretq_f32_u32(b); }
+	uint32x4_t bits() const { return vreinterpretq_u32_f32(v); }
+
+	friend Vec operator+(Vec a, Vec b) { return vaddq_f32(a.v, b.v); }
+	friend Vec operator-(Vec a, Vec b) { return vsubq_f32(a.v, b.v); }
+	friend Vec operator*(Vec a, Vec b) { return vmulq_f32(a.v, b.v); }
+	friend Vec operator/(Vec a, Vec b) { return vdivq_f32(a.v, b.v); }
+	friend Vec operator<(Vec a, Vec b) { return fromBits(vcltq_f32(a.v, b.v)); }
+	friend Vec operator>(Vec a, Vec b) { return fromBits(vcgtq_f32(a.v, b.v)); }
+	friend Vec operator<=(Vec a, Vec b) { return fromBits(vcleq_f32(a.v, b.v)); }
+	friend Vec operator==(Vec a, Vec b) { return fromBits(vceqq_f32(a.v, b.v)); }
+	friend Vec operator&(Vec a, Vec b) { return fromBits(vandq_u32(a.bits(), b.bits())); }
+	friend Vec operator|(Vec a, Vec b) { return fromBits(vorrq_u32(a.bits(), b.bits())); }
+	friend Vec operator^(Vec a, Vec b) { return fromBits(veorq_u32(a.bits(), b.bits())); }
+	friend Vec andnot(Vec a, Vec b) { return fromBits(vbicq_u32(b.bits(), a.bits())); }
+	friend Vec min(Vec a, Vec b) { return vminq_f32(a.v, b.v); }
+	friend Vec max(Vec a, Vec b) { return vmaxq_f32(a.v, b.v); }
+
+	static Vec pow2i(Vec n) {
+		const int32x4_t e = vaddq_s32(vcvtnq_s32_f32(n.v), vdupq_n_s32(127));
+		return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+	}
+};
+
+template<>
+struct Vec<double>
+{
+	static constexpr int size = 2;
+	float64x2_t v;
+
+	Vec() = default;
+	Vec(float64x2_t v) : v(v) {}
+	Vec(double x) : v(vdupq_n_f64(x)) {}
+
+	static Vec load(const double* p) { return vld1q_f64(p); }
+	void store(double* p) const { vst1q_f64(p, v); }
+
+	static Vec fromBits(uint64x2_t b) { return vreinterpretq_f64_u64(b); }
+	uint64x2_t bits() const { return vreinterpretq_u64_f64(v); }
+
+	friend Vec operator+(Vec a, Vec b) { return vaddq_f64(a.v, b.v); }
+	friend Vec operator-(Vec a, Vec b) { return vsubq_f64(a.v, b.v); }
+	friend Vec operator*(Vec a, Vec b) { return vmulq_f64(a.v, b.v); }
+	friend Vec operator/(Vec a, Vec b) { return vdivq_f64(a.v, b.v); }
+	friend Vec operator<(Vec a, Vec b) { return fromBits(vcltq_f64(a.v, b.v)); }
+	friend Vec operator>(Vec a, Vec b) { return fromBits(vcgtq_f64(a.v, b.v)); }
+	friend Vec operator<=(Vec a, Vec b) { return fromBits(vcleq_f64(a.v, b.v)); }
+	friend Vec operator==(Vec a, Vec b) { return fromBits(vceqq_f64(a.v, b.v)); }
+	friend Vec operator&(Vec a, Vec b) { return fromBits(vandq_u64(a.bits(), b.bits())); }
+	friend Vec operator|(Vec a, Vec b) { return fromBits(vorrq_u64(a.bits(), b.bits())); }
+	friend Vec operator^(Vec a, Vec b) { return fromBits(veorq_u64(a.bits(), b.bits())); }
+	friend Vec andnot(Vec a, Vec b) { return fromBits(vbicq_u64(b.bits(), a.bits())); }
+	friend Vec min(Vec a, Vec b) { return vminq_f64(a.v, b.v); }
+	friend Vec max(Vec a, Vec b) { return vmaxq_f64(a.v, b.v); }
+
+	static Vec pow2i(Vec n) {
+		const int64x2_t e = vaddq_s64(vcvtnq_s64_f64(n.v), vdupq_n_s64(1023));
+		return vreinterpretq_f64_s64(vshlq_n_s64(e, 52));
+	}
+};
+
+
+#else // scalar fallback
+
+template<class T>
+struct ScalarBits;
+template<>
+struct ScalarBits<float>
+{
+	using type = uint32_t;
+	static constexpr int mantissaBits = 23;
+	static constexpr int bias = 127;
+};
+template<>
+struct ScalarBits<double>
+{
+	using type = uint64_t;
+	static constexpr int mantissaBits = 52;
+	static constexpr int bias = 1023;
+};
+
+template<class T>
+struct Vec
+{
+	using Bits = typename ScalarBits<T>::type;
+	static constexpr int size = 1;
+	T v;
+
+	Vec() = default;
+	Vec(T x) : v(x) {}
+
+	static Vec load(const T* p) { return *p; }
+	void store(T* p) const { *p = v; }
+
+	static Vec fromBits(Bits b) {
+		T x;
+		std::memcpy(&x, &b, sizeof(T));
+		return x;
+	}
+	Bits bits() const {
+		Bits b;
+		std::memcpy(&b, &v, sizeof(T));
+		return b;
+	}
+	static Vec mask(bool b) { return fromBits(b ? ~Bits{ 0 } : Bits{ 0 }); }
+
+	friend Vec operator+(Vec a, Vec b) { return a.v + b.v; }
+	friend Vec operator-(Vec a, Vec b) { return a.v - b.v; }
+	friend Vec operator*(Vec a, Vec b) { return a.v * b.v; }
+	friend Vec operator/(Vec a, Vec b) { return a.v / b.v; }
+	friend Vec operator<(Vec a, Vec b) { return mask(a.v < b.v); }
+	friend Vec operator>(Vec a, Vec b) { return mask(a.v > b.v); }
+	friend Vec operator<=(Vec a, Vec b) { return mask(a.v <= b.v); }
+	friend Vec operator==(Vec a, Vec b) { return mask(a.v == b.v); }
+	friend Vec operator&(Vec a, Vec b) { return fromBits(a.bits() & b.bits()); }
+	friend Vec operator|(Vec a, Vec b) { return fromBits(a.bits() | b.bits()); }
+	friend Vec operator^(Vec a, Vec b) { return fromBits(a.bits() ^ b.bits()); }
+	friend Vec andnot(Vec a, Vec b) { return fromBits(~a.bits() & b.bits()); }
+	friend Vec min(Vec a, Vec b) { return b.v < a.v ? b : a; }
+	friend Vec max(Vec a, Vec b) { return a.v < b.v ? b : a; }
+
+	static Vec pow2i(Vec n) {
+		const Bits e = static_cast<Bits>(static_cast<int64_t>(n.v) + ScalarBits<T>::bias);
+		return fromBits(e << ScalarBits<T>::mantissaBits);
+	}
+};
+
+#endif
+
+
+// -- common helpers ---------------------------------------------------------------------------
+
+template<class T>
+inline Vec<T> select(Vec<T> mask, Vec<T> a, Vec<T> b) {
+	return (mask & a) | andnot(mask, b);
+}
+
+template<class T>
+inline Vec<T> signMask() {
+	return Vec<T>(T(-0.0));
+}
+
+template<class T>
+inline Vec<T> abs(Vec<T> a) {
+	return andnot(signMask<T>(), a);
+}
+
+// Rounds to the nearest integer (ties to even) for |a| < 2²² (float) or |a| < 2⁵¹ (double)
+template<class T>
+inline Vec<T> roundNearest(Vec<T> a) {
+	const Vec<T> magic(sizeof(T) == 4 ? T(12582912.0) : T(6755399441055744.0)); // 1.5·2²³ or 1.5·2⁵²
+	return (a + magic) - magic;
+}
+
+} // namespace Simd
+} // namespace Uberton
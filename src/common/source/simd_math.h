@@ -0,0 +1,281 @@
+// Vectorized transcendental functions for float and double
+//  - sin, cos, sincos
+//  - exp and complex exp
+//  - tanh
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+
+namespace Uberton {
+namespace Simd {
+
+//
+// Polynomial approximations after Cephes (S. L. Moshier) evaluated lane-wise. All functions come
+// in a Vec<T> version and an array version (out may alias x).
+//
+// Maximum error measured against long double (random arguments over the stated domain, checked by
+// the test uberton_simd_math_test in src/tools):
+//
+//                 float                                 double
+//   sin/cos       1.6 ulp (|x| ≤ 4)                     1.6 ulp (|x| ≤ 4)
+//                 absolute 0.8·2⁻²³ (|x| ≤ 8192)        2.3 ulp, absolute 2⁻⁵² (|x| ≤ 10⁶)
+//   exp           1 ulp   (-87 ≤ x ≤ 88)                1.7 ulp (-708 ≤ x ≤ 709)
+//   tanh          1.4 ulp                               1.4 ulp
+//
+// For float, the relative error of sin/cos grows close to the zeros for |x| > 4 (π/2 is only
+// split into 43 bits), the absolute error remains bounded. The trigonometric functions lose
+// accuracy outside of the domain, exp() clamps its argument to the domain and tanh() is exact (±1)
+// for large arguments. NaN and infinity are not handled.
+//
+
+namespace Detail {
+
+template<class T>
+struct Constants;
+
+template<>
+struct Constants<float>
+{
+	// π/2 split into three parts for the argument reduction
+	static constexpr float pio2_1 = 1.5703125f;
+	static constexpr float pio2_2 = 4.837512969970703125e-4f;
+	static constexpr float pio2_3 = 7.54978995489188216e-8f;
+
+	static Vec<float> sinPoly(Vec<float> r, Vec<float> z) {
+		const Vec<float> p = (Vec<float>(-1.9515295891e-4f) * z + Vec<float>(8.3321608736e-3f)) * z + Vec<float>(-1.6666654611e-1f);
+		return r + r * z * p;
+	}
+	static Vec<float> cosPoly(Vec<float> z) {
+		const Vec<float> p = (Vec<float>(2.443315711809948e-5f) * z + Vec<float>(-1.388731625493765e-3f)) * z + Vec<float>(4.166664568298827e-2f);
+		return Vec<float>(1.f) - Vec<float>(0.5f) * z + z * z * p;
+	}
+
+	static constexpr float expMin = -87.f;
+	static constexpr float expMax = 88.f;
+	static Vec<float> expReduced(Vec<float> x, Vec<float> n) {
+		x = x - n * Vec<float>(0.693359375f) - n * Vec<float>(-2.12194440e-4f);
+		Vec<float> p(1.9875691500e-4f);
+		p = p * x + Vec<float>(1.3981999507e-3f);
+		p = p * x + Vec<float>(8.3334519073e-3f);
+		p = p * x + Vec<float>(4.1665795894e-2f);
+		p = p * x + Vec<float>(1.6666665459e-1f);
+		p = p * x + Vec<float>(5.0000001201e-1f);
+		return p * x * x + x + Vec<float>(1.f);
+	}
+
+	static constexpr float tanhMax = 9.f;
+	static Vec<float> tanhSmall(Vec<float> x) {
+		const Vec<float> z = x * x;
+		Vec<float> p(-5.70498872745e-3f);
+		p = p * z + Vec<float>(2.06390887954e-2f);
+		p = p * z + Vec<float>(-5.37397155531e-2f);
+		p = p * z + Vec<float>(1.33314422036e-1f);
+		p = p * z + Vec<float>(-3.33332819422e-1f);
+		return x + x * z * p;
+	}
+};
+
+template<>
+struct Constants<double>
+{
+	static constexpr double pio2_1 = 1.57079632673412561417e+00;
+	static constexpr double pio2_2 = 6.07710050630396597660e-11;
+	static constexpr double pio2_3 = 2.02226624879595063154e-21;
+
+	static Vec<double> sinPoly(Vec<double> r, Vec<double> z) {
+		Vec<double> p(1.58962301576546568060e-10);
+		p = p * z + Vec<double>(-2.50507477628578072866e-8);
+		p = p * z + Vec<double>(2.75573136213857245213e-6);
+		p = p * z + Vec<double>(-1.98412698295895385996e-4);
+		p = p * z + Vec<double>(8.33333333332211858878e-3);
+		p = p * z + Vec<double>(-1.66666666666666307295e-1);
+		return r + r * z * p;
+	}
+	static Vec<double> cosPoly(Vec<double> z) {
+		Vec<double> p(-1.13585365213876817300e-11);
+		p = p * z + Vec<double>(2.08757008419747316778e-9);
+		p = p * z + Vec<double>(-2.75573141792967388112e-7);
+		p = p * z + Vec<double>(2.48015872888517045348e-5);
+		p = p * z + Vec<double>(-1.38888888888730564116e-3);
+		p = p * z + Vec<double>(4.16666666666665929218e-2);
+		return Vec<double>(1.) - Vec<double>(0.5) * z + z * z * p;
+	}
+
+	static constexpr double expMin = -708.;
+	static constexpr double expMax = 709.;
+	static Vec<double> expReduced(Vec<double> x, Vec<double> n) {
+		// Padé approximation exp(x) ≈ 1 + 2x·P(x²)/(Q(x²) - x·P(x²))
+		x = x - n * Vec<double>(6.93145751953125e-1) - n * Vec<double>(1.42860682030941723212e-6);
+		const Vec<double> xx = x * x;
+		const Vec<double> px = x * ((Vec<double>(1.26177193074810590878e-4) * xx + Vec<double>(3.02994407707441961300e-2)) * xx + Vec<double>(9.99999999999999999910e-1));
+		Vec<double> q(3.00198505138664455042e-6);
+		q = q * xx + Vec<double>(2.52448340349684104192e-3);
+		q = q * xx + Vec<double>(2.27265548208155028766e-1);
+		q = q * xx + Vec<double>(2.00000000000000000009e0);
+		return Vec<double>(1.) + Vec<double>(2.) * (px / (q - px));
+	}
+
+	static constexpr double tanhMax = 22.;
+	static Vec<double> tanhSmall(Vec<double> x) {
+		const Vec<double> z = x * x;
+		const Vec<double> p = (Vec<double>(-9.64399179425052238628e-1) * z + Vec<double>(-9.92877231001918586564e1)) * z + Vec<double>(-1.61468768441708447952e3);
+		const Vec<double> q = ((z + Vec<double>(1.12811678491632931402e2)) * z + Vec<double>(2.23548839060100448583e3)) * z + Vec<double>(4.84406305325125486048e3);
+		return x + x * z * (p / q);
+	}
+};
+
+// Applies f to n elements, the tail is padded into a full vector
+template<class T, class F>
+inline void apply(const T* x, T* out, int n, F&& f) {
+	constexpr int size = Vec<T>::size;
+	int i = 0;
+	for (; i + size <= n; i += size) {
+		f(Vec<T>::load(x + i)).store(out + i);
+	}
+	if (i < n) {
+		T tmp[size]{};
+		for (int k = 0; k < size && i + k < n; k++) tmp[k] = x[i + k];
+		f(Vec<T>::load(tmp)).store(tmp);
+		for (int k = 0; k < size && i + k < n; k++) out[i + k] = tmp[k];
+	}
+}
+
+} // namespace Detail
+
+
+template<class T>
+inline void sincos(Vec<T> x, Vec<T>& s, Vec<T>& c) {
+	using C = Detail::Constants<T>;
+	const Vec<T> sign = x & signMask<T>();
+	const Vec<T> ax = abs(x);
+
+	// x = n·π/2 + r with |r| ≤ π/4
+	const Vec<T> n = roundNearest(ax * Vec<T>(T(0.63661977236758134308))); // 2/π
+	const Vec<T> r = ((ax - n * Vec<T>(C::pio2_1)) - n * Vec<T>(C::pio2_2)) - n * Vec<T>(C::pio2_3);
+	const Vec<T> q = n - Vec<T>(4) * roundNearest(n * Vec<T>(T(0.25)) - Vec<T>(T(0.375))); // n mod 4
+
+	const Vec<T> z = r * r;
+	const Vec<T> sr = C::sinPoly(r, z);
+	const Vec<T> cr = C::cosPoly(z);
+
+	const Vec<T> odd = (q == Vec<T>(1)) | (q == Vec<T>(3));
+	const Vec<T> sinNeg = Vec<T>(T(1.5)) < q;
+	const Vec<T> cosNeg = (q == Vec<T>(1)) | (q == Vec<T>(2));
+	s = select(odd, cr, sr) ^ (sinNeg & signMask<T>()) ^ sign;
+	c = select(odd, sr, cr) ^ (cosNeg & signMask<T>());
+}
+
+template<class T>
+inline Vec<T> sin(Vec<T> x) {
+	Vec<T> s, c;
+	sincos(x, s, c);
+	return s;
+}
+
+template<class T>
+inline Vec<T> cos(Vec<T> x) {
+	Vec<T> s, c;
+	sincos(x, s, c);
+	return c;
+}
+
+template<class T>
+inline Vec<T> exp(Vec<T> x) {
+	using C = Detail::Constants<T>;
+	x = min(max(x, Vec<T>(C::expMin)), Vec<T>(C::expMax));
+	const Vec<T> n = roundNearest(x * Vec<T>(T(1.44269504088896340736))); // log₂e
+	return C::expReduced(x, n) * Vec<T>::pow2i(n);
+}
+
+template<class T>
+inline Vec<T> tanh(Vec<T> x) {
+	using C = Detail::Constants<T>;
+	const Vec<T> sign = x & signMask<T>();
+	const Vec<T> ax = min(abs(x), Vec<T>(C::tanhMax));
+	// tanh|x| = 1 - 2/(exp(2|x|) + 1)
+	const Vec<T> large = (Vec<T>(1) - Vec<T>(2) / (exp(ax + ax) + Vec<T>(1))) | sign;
+	return select(ax < Vec<T>(T(0.625)), C::tanhSmall(x), large);
+}
+
+// exp(re + i·im) = exp(re)·(cos(im) + i·sin(im))
+template<class T>
+inline void cexp(Vec<T> re, Vec<T> im, Vec<T>& outRe, Vec<T>& outIm) {
+	Vec<T> s, c;
+	sincos(im, s, c);
+	const Vec<T> r = exp(re);
+	outRe = r * c;
+	outIm = r * s;
+}
+
+
+// -- array versions ---------------------------------------------------------------------------
+
+template<class T>
+inline void sin(const T* x, T* out, int n) {
+	Detail::apply(x, out, n, [](Vec<T> v) { return sin(v); });
+}
+
+template<class T>
+inline void cos(const T* x, T* out, int n) {
+	Detail::apply(x, out, n, [](Vec<T> v) { return cos(v); });
+}
+
+template<class T>
+inline void exp(const T* x, T* out, int n) {
+	Detail::apply(x, out, n, [](Vec<T> v) { return exp(v); });
+}
+
+template<class T>
+inline void tanh(const T* x, T* out, int n) {
+	Detail::apply(x, out, n, [](Vec<T> v) { return tanh(v); });
+}
+
+template<class T>
+inline void sincos(const T* x, T* outSin, T* outCos, int n) {
+	constexpr int size = Vec<T>::size;
+	for (int i = 0; i < n; i += size) {
+		const int count = std::min(size, n - i);
+		T tmp[size]{}, s[size], c[size];
+		std::copy(x + i, x + i + count, tmp);
+		Vec<T> vs, vc;
+		sincos(Vec<T>::load(tmp), vs, vc);
+		vs.store(s);
+		vc.store(c);
+		std::copy(s, s + count, outSin + i);
+		std::copy(c, c + count, outCos + i);
+	}
+}
+
+// outRe[i] + i·outIm[i] = exp(re[i] + i·im[i])
+template<class T>
+inline void cexp(const T* re, const T* im, T* outRe, T* outIm, int n) {
+	constexpr int size = Vec<T>::size;
+	for (int i = 0; i < n; i += size) {
+		const int count = std::min(size, n - i);
+		T a[size]{}, b[size]{};
+		std::copy(re + i, re + i + count, a);
+		std::copy(im + i, im + i + count, b);
+		Vec<T> vr, vi;
+		cexp(Vec<T>::load(a), Vec<T>::load(b), vr, vi);
+		vr.store(a);
+		vi.store(b);
+		std::copy(a, a + count, outRe + i);
+		std::copy(b, b + count, outIm + i);
+	}
+}
+
+} // namespace Simd
+} // namespace Uberton
@@ -0,0 +1,90 @@
+// Per-sample smoothing of continuous parameters
+//  - a set of RampedValue smoothers that are rendered into control buffers once per block
+//  - smoothers that have reached their target are skipped
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "parameters.h"
+#include <array>
+#include <cmath>
+
+namespace Uberton {
+
+//
+// Parameters that are applied once per block jump at the block boundaries, which is audible as
+// zipper noise with large blocks. Here each smoother ramps linearly to its target over a fixed
+// time. process() renders the ramps of one (sub-)block into control buffers that the DSP code
+// reads per sample. A smoother that has reached its target has no control buffer in that block
+// (ramp() returns nullptr), so the DSP code can use the constant get() instead and steady
+// parameters cost nothing.
+//
+// Usage:
+//   smoothers.setRampTime(0.02, sampleRate);
+//   smoothers.reset(kGain, gain);                      // initial value, no ramp
+//   smoothers.set(kGain, newGain);                     // once per process call
+//   smoothers.process(blockSize);                      // once per (sub-)block ≤ maxBlockSize
+//   const float* g = smoothers.ramp(kGain);            // nullptr: use smoothers.get(kGain)
+//
+template<class FloatType, int numSmoothers, int maxBlockSize>
+class ParameterSmoothers
+{
+public:
+	void setRampTime(double seconds, double sampleRate) {
+		const int numSamples = static_cast<int>(std::lround(seconds * sampleRate));
+		for (auto& smoother : smoothers) {
+			smoother.setRampLength(numSamples);
+		}
+	}
+
+	void reset(int i, FloatType value) {
+		smoothers[i].reset(value);
+		rendered[i] = false;
+	}
+
+	void set(int i, FloatType target) {
+		smoothers[i].set(target);
+	}
+
+	/// Render the next numSamples (≤ maxBlockSize) values of all ramping smoothers
+	void process(int numSamples) {
+		for (int i = 0; i < numSmoothers; i++) {
+			rendered[i] = smoothers[i].isRamping();
+			if (rendered[i]) {
+				smoothers[i].render(buffers[i].data(), numSamples);
+			}
+		}
+	}
+
+	/// Values of smoother i for each sample of the last processed block or nullptr if it was
+	/// constant during that block
+	const FloatType* ramp(int i) const {
+		return rendered[i] ? buffers[i].data() : nullptr;
+	}
+
+	/// Value at the end of the last processed block
+	FloatType get(int i) const {
+		return smoothers[i].get();
+	}
+
+	bool isRamping(int i) const {
+		return smoothers[i].isRamping();
+	}
+
+private:
+	std::array<RampedValue<FloatType>, numSmoothers> smoothers{};
+	std::array<std::array<FloatType, maxBlockSize>, numSmoothers> buffers{};
+	std::array<bool, numSmoothers> rendered{};
+};
+
+} // namespace Uberton
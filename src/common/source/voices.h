@@ -0,0 +1,289 @@
+// Fixed capacity voice pool for polyphonic instruments
+//  - preallocated voices, no allocation on note on/off
+//  - O(1) voice allocation, note off and freeing (stealing is linear in the number of voices)
+//  - voice stealing by energy (released voices) or age (held voices)
+//  - sample accurate note event scheduling
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace Uberton {
+
+//
+// The pool keeps the indices of the free voices in a stack and the indices of the sounding
+// voices in a dense list (with the position of each voice in that list for O(1) removal).
+// Only the voices in the active list need to be processed. Each pitch maps to at most one
+// voice, so note off does not need to search.
+//
+// When all voices are in use, a new note steals
+//   - the released voice with the least energy, or if all voices are held,
+//   - the oldest voice.
+//
+// Voice needs to provide
+//   - float energy() const;   (any measure of loudness, only compared between voices)
+//
+// Usage:
+//   int v = pool.noteOn(pitch, retriggered);   // then (re)initialize pool[v]
+//   int v = pool.noteOff(pitch);               // then release pool[v] if v != noVoice
+//   pool.forEachActive([](Voice& voice) { ... });
+//   pool.freeIf([](const Voice& voice) { return voice.energy() < threshold; });
+//
+template<class Voice, int maxVoices, int numPitches = 128>
+class VoicePool
+{
+public:
+	static_assert(maxVoices > 0, "the pool needs at least one voice");
+	static constexpr int noVoice = -1;
+
+	VoicePool() { reset(); }
+
+	// Stop all voices
+	void reset() {
+		numFree = maxVoices;
+		for (int v = 0; v < maxVoices; v++) {
+			freeVoices[v] = maxVoices - 1 - v; // voice 0 is allocated first
+			slots[v] = {};
+		}
+		numActive = 0;
+		pitchVoices.fill(noVoice);
+	}
+
+	// Get a voice for the pitch. If the pitch is already playing, its voice is reused and
+	// retriggered is set to true.
+	int noteOn(int pitch, bool& retriggered) {
+		retriggered = false;
+		if (pitch < 0 || pitch >= numPitches) return noVoice;
+
+		int v = pitchVoices[pitch];
+		if (v != noVoice) {
+			retriggered = true;
+		}
+		else {
+			v = numFree > 0 ? freeVoices[--numFree] : steal();
+			if (slots[v].active) {
+				unmapPitch(v); // stolen
+			}
+			else {
+				activate(v);
+			}
+			slots[v].pitch = pitch;
+			pitchVoices[pitch] = v;
+		}
+		slots[v].released = false;
+		slots[v].age = noteCounter++;
+		return v;
+	}
+
+	// Mark the voice of the pitch as released. Returns the voice or noVoice if the pitch is
+	// not playing. The voice keeps sounding until it is freed.
+	int noteOff(int pitch) {
+		if (pitch < 0 || pitch >= numPitches) return noVoice;
+		const int v = pitchVoices[pitch];
+		if (v == noVoice) return noVoice;
+		slots[v].released = true;
+		unmapPitch(v);
+		return v;
+	}
+
+	// Call f(voice) for all sounding voices
+	template<class F>
+	void forEachActive(F&& f) {
+		for (int k = 0; k < numActive; k++) {
+			f(voices[activeVoices[k]]);
+		}
+	}
+
+	// Free all sounding voices for which finished(voice) is true
+	template<class F>
+	void freeIf(F&& finished) {
+		for (int k = numActive - 1; k >= 0; k--) {
+			const int v = activeVoices[k];
+			if (finished(static_cast<const Voice&>(voices[v]))) {
+				free(v);
+			}
+		}
+	}
+
+	Voice& operator[](int v) { return voices[v]; }
+	const Voice& operator[](int v) const { return voices[v]; }
+
+	bool isActive(int v) const { return slots[v].active; }
+	bool isReleased(int v) const { return slots[v].released; }
+	int getNumActive() const { return numActive; }
+	static constexpr int capacity() { return maxVoices; }
+
+private:
+	struct Slot
+	{
+		uint64_t age{ 0 };
+		int pitch{ noVoice };
+		int activeIndex{ 0 }; // position in activeVoices
+		bool active{ false };
+		bool released{ false };
+	};
+
+	void activate(int v) {
+		slots[v].active = true;
+		slots[v].activeIndex = numActive;
+		activeVoices[numActive++] = v;
+	}
+
+	void free(int v) {
+		unmapPitch(v);
+		// move the last active voice into the gap
+		const int k = slots[v].activeIndex;
+		const int last = activeVoices[--numActive];
+		activeVoices[k] = last;
+		slots[last].activeIndex = k;
+		slots[v].active = false;
+		freeVoices[numFree++] = v;
+	}
+
+	void unmapPitch(int v) {
+		const int pitch = slots[v].pitch;
+		if (pitch != noVoice && pitchVoices[pitch] == v) {
+			pitchVoices[pitch] = noVoice;
+		}
+		slots[v].pitch = noVoice;
+	}
+
+	// Only called when all voices are active
+	int steal() const {
+		int quietest = noVoice, oldest = noVoice;
+		float minEnergy = 0;
+		for (int k = 0; k < numActive; k++) {
+			const int v = activeVoices[k];
+			if (slots[v].released) {
+				const float e = voices[v].energy();
+				if (quietest == noVoice || e < minEnergy) {
+					quietest = v;
+					minEnergy = e;
+				}
+			}
+			else if (oldest == noVoice || slots[v].age < slots[oldest].age) {
+				oldest = v;
+			}
+		}
+		return quietest != noVoice ? quietest : oldest;
+	}
+
+	std::array<Voice, maxVoices> voices{};
+	std::array<Slot, maxVoices> slots{};
+	std::array<int, maxVoices> freeVoices{};
+	std::array<int, maxVoices> activeVoices{};
+	std::array<int, numPitches> pitchVoices{};
+	int numFree{ 0 };
+	int numActive{ 0 };
+	uint64_t noteCounter{ 0 };
+};
+
+
+struct NoteEvent
+{
+	int sampleOffset;
+	int pitch;
+	float velocity; // 0 for note off
+};
+
+//
+// Note events of one process call in the order of their sample offsets. Instead of applying
+// all events at the start of the block, process() renders the block in segments up to each
+// event offset and applies the event in between, so note timing is sample accurate for any
+// block size while the voices are still rendered block-wise.
+//
+// Events that have not been processed (i.e. because the audio processing was bypassed) should be
+// flushed before the events of the next block are pushed. If the queue is full, the earliest event
+// (the new one or the first queued one) is applied right away to make room. An event pushed after
+// that with an earlier offset is moved to the offset of the applied event, so the events are always
+// applied in the order of their offsets and only the timing of the early ones is lost.
+//
+// Usage:
+//   queue.flush(apply);                   // leftovers of the last call
+//   queue.push({ sampleOffset, pitch, velocity }, apply);
+//   queue.process(numSamples, [](int start, int end) { render(start, end); }, apply);
+//
+template<int capacity>
+class NoteEventQueue
+{
+public:
+	// apply(event) handles the events that do not fit into the queue anymore
+	template<class Apply>
+	void push(NoteEvent event, Apply&& apply) {
+		// too late to be applied before the events that were applied early
+		event.sampleOffset = std::max(event.sampleOffset, appliedOffset);
+		if (numEvents == capacity) {
+			// make room by applying the earliest event
+			if (event.sampleOffset < events[0].sampleOffset) {
+				applyEarly(event, apply);
+				return;
+			}
+			applyEarly(events[0], apply);
+			std::copy(events.begin() + 1, events.begin() + numEvents, events.begin());
+			numEvents--;
+		}
+		// hosts deliver the events sorted, keep it that way if one doesn't
+		int k = numEvents++;
+		for (; k > 0 && events[k - 1].sampleOffset > event.sampleOffset; k--) {
+			events[k] = events[k - 1];
+		}
+		events[k] = event;
+	}
+
+	// render(start, end) renders the samples [start, end), apply(event) handles an event
+	template<class Render, class Apply>
+	void process(int numSamples, Render&& render, Apply&& apply) {
+		int position = 0;
+		for (int k = 0; k < numEvents; k++) {
+			const int offset = std::min(std::max(events[k].sampleOffset, position), numSamples);
+			if (offset > position) {
+				render(position, offset);
+				position = offset;
+			}
+			apply(events[k]);
+		}
+		if (position < numSamples) {
+			render(position, numSamples);
+		}
+		numEvents = 0;
+		appliedOffset = 0;
+	}
+
+	// Apply all events without rendering
+	template<class Apply>
+	void flush(Apply&& apply) {
+		for (int k = 0; k < numEvents; k++) {
+			apply(events[k]);
+		}
+		numEvents = 0;
+		appliedOffset = 0;
+	}
+
+	bool empty() const { return numEvents == 0; }
+
+private:
+	template<class Apply>
+	void applyEarly(const NoteEvent& event, Apply&& apply) {
+		appliedOffset = event.sampleOffset;
+		apply(event);
+	}
+
+	std::array<NoteEvent, capacity> events{};
+	int numEvents{ 0 };
+	int appliedOffset{ 0 }; // offset of the last event that was applied before process()
+};
+
+} // namespace Uberton
@@ -563,6 +563,68 @@ inline T generalized_assoc_legendre_plus_onehalf(T l, T m, T x) {
 //
 
 
+// Diagonal element P_|μ|^μ(x) of the associated legendre functions (with Condon-Shortley phase)
+// for integer μ or negative half-integer μ and sinTheta = √(1 − x²):
+//     P_m^m = (−1)ᵐ·(2m − 1)!!·sinᵐθ               (μ = m ≥ 0)
+//     P_ν^−ν = sin^νθ / (2^ν·Γ(ν + 1))             (μ = −ν ≤ 0)
+template<class T>
+inline T assoc_legendre_diagonal(T mu, T sinTheta) {
+	T p{ 1 };
+	if (mu > 0) {
+		const int m = static_cast<int>(mu);
+		for (int k = 1; k <= m; k++) {
+			p *= -(2 * k - 1) * sinTheta;
+		}
+	} else {
+		const int n = static_cast<int>(-mu);
+		const T f = -mu - n; // 0 or ½
+		if (f != 0) {
+			p = std::sqrt(sinTheta * T(0.5)) / T(0.8862269254527580); // Γ(3/2) = √π/2
+		}
+		for (int k = 1; k <= n; k++) {
+			p *= sinTheta / (2 * (k + f));
+		}
+	}
+	return p;
+}
+
+// Evaluates the associated legendre functions P_ν^μ(x) of fixed order μ for all degrees
+// ν = |μ|, |μ| + 1, ..., |μ| + count − 1 at once, using the stable upward recurrence
+//     (ν − μ + 1)·P_ν₊₁^μ = (2ν + 1)·x·P_ν^μ − (ν + μ)·P_ν₋₁^μ
+// starting from the diagonal. μ needs to be an integer or a negative half-integer and
+// sinTheta = √(1 − x²). For integer μ the results match assoc_legendre() and for half-integer μ
+// they match generalized_assoc_legendre() but without restrictions and iterative series.
+template<class T>
+inline void assoc_legendre_degrees(T mu, T x, T sinTheta, int count, T* out) {
+	if (count <= 0) return;
+	const T nu0 = std::abs(mu);
+	out[0] = assoc_legendre_diagonal(mu, sinTheta);
+	if (count == 1) return;
+	out[1] = (2 * nu0 + 1) * x * out[0] / (nu0 - mu + 1);
+	for (int k = 2; k < count; k++) {
+		const T nu = nu0 + k - 1;
+		out[k] = ((2 * nu + 1) * x * out[k - 1] - (nu + mu) * out[k - 2]) / (nu - mu + 1);
+	}
+}
+
+// Single value version of assoc_legendre_degrees() for degree ν ≥ |μ| with ν − |μ| integer.
+template<class T>
+inline T assoc_legendre_general(T nu, T mu, T x, T sinTheta) {
+	const T nu0 = std::abs(mu);
+	const int count = static_cast<int>(nu - nu0 + T(0.5)) + 1;
+	T p0 = assoc_legendre_diagonal(mu, sinTheta);
+	if (count == 1) return p0;
+	T p1 = (2 * nu0 + 1) * x * p0 / (nu0 - mu + 1);
+	for (int k = 2; k < count; k++) {
+		const T n = nu0 + k - 1;
+		T p2 = ((2 * n + 1) * x * p1 - (n + mu) * p0) / (n - mu + 1);
+		p0 = p1;
+		p1 = p2;
+	}
+	return p1;
+}
+
+
 //template<typename T, int size>
 //struct CosTable {
 //	T values[size];
@@ -0,0 +1,251 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <lockfree.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+namespace Uberton {
+namespace ResonatorPlugin {
+
+//
+// Evaluates eigenfunctions at new input/output positions on a background thread.
+//
+// The audio thread posts the newest positions with request() (lock-free) and picks up finished
+// evaluations with fetch(). Both directions go through triple buffers, so the audio thread never
+// waits for the worker and a burst of position changes is coalesced into a single evaluation.
+// The worker uses its own instance of the eigenvalue class, so it never touches the resonator
+// that is being processed.
+//
+// Each request carries the resonator dimension (the mode order depends on it) and a generation
+// number, that the caller can use to discard results that have become stale in the meantime.
+//
+// Additionally, the worker tabulates the eigenfunctions along the position space curves
+// (base position + curve(t) for curveTableSize + 1 equidistant t in [0,1]). With such a table,
+// automating the curve parameter only needs a linear interpolation of N weights per channel.
+// Tables are built with lower priority than single position requests.
+//
+// The number of input and output positions may differ (i.e. stereo input, surround output).
+// Positions and results are sized for the larger one, only the first numPositions(job) are used.
+//
+template<class Resonator>
+class EigenFunctionWorker
+{
+public:
+	static constexpr int channels = std::max(Resonator::numChannels(), Resonator::numOutputChannels());
+	static constexpr int N = Resonator::maxOrder();
+	static constexpr int curveTableSize = 256; // number of intervals
+
+	using EigenValues = typename Resonator::EigenValues;
+	using SpaceVec = typename Resonator::SpaceVec;
+	using EFArray = typename Resonator::template EFArrayN<channels>;
+	using Positions = std::array<SpaceVec, channels>;
+	using real = typename Resonator::real;
+
+	enum Job {
+		InputPositions,
+		OutputPositions,
+		numJobs
+	};
+
+	static constexpr int numPositions(Job job) {
+		return job == InputPositions ? Resonator::numChannels() : Resonator::numOutputChannels();
+	}
+
+	// Space curve t ↦ offset to the base positions (needs to be thread-safe)
+	using Curve = std::function<SpaceVec(Job job, double t)>;
+
+	struct Result
+	{
+		EFArray ef;
+		int dim;
+		uint64_t generation;
+	};
+
+	struct CurveTable
+	{
+		// (real) eigenfunction evaluations at the base positions + curve(k / curveTableSize),
+		// one table per position of the job (allocated by the worker thread)
+		std::vector<std::array<std::array<real, N>, curveTableSize + 1>> values;
+		int dim;
+		uint64_t generation;
+
+		// Interpolate the weights for curve parameters t[ch] ∈ [0,1]
+		void interpolate(const std::array<double, channels>& t, EFArray& ef) const {
+			for (int ch = 0; ch < static_cast<int>(values.size()); ch++) {
+				const double x = std::min(std::max(t[ch], 0.0), 1.0) * curveTableSize;
+				const int k = std::min(static_cast<int>(x), curveTableSize - 1);
+				const real f = static_cast<real>(x - k);
+				const auto& a = values[ch][k];
+				const auto& b = values[ch][k + 1];
+				for (int i = 0; i < N; i++) {
+					ef[ch][i] = a[i] + f * (b[i] - a[i]);
+				}
+			}
+		}
+	};
+
+	EigenFunctionWorker() = default;
+	EigenFunctionWorker(const EigenFunctionWorker&) = delete;
+	EigenFunctionWorker& operator=(const EigenFunctionWorker&) = delete;
+	~EigenFunctionWorker() { stop(); }
+
+	// Needs to be set before start() for curve tables to be built
+	void setCurve(Curve newCurve) { curve = std::move(newCurve); }
+
+	void start() {
+		if (thread.joinable()) return;
+		quit = false;
+		thread = std::thread([this] { run(); });
+	}
+
+	// Requests that are posted while the worker is stopped are evaluated after the next start()
+	void stop() {
+		if (!thread.joinable()) return;
+		quit.store(true);
+		wakeup.post();
+		thread.join();
+	}
+
+	// Audio thread: post new positions. Only the latest request per job is evaluated.
+	void request(Job job, const Positions& positions, int dim, uint64_t generation) {
+		Request& r = jobs[job].requests.writeBuffer();
+		r.positions = positions;
+		r.dim = dim;
+		r.generation = generation;
+		jobs[job].requests.publish();
+		notify();
+	}
+
+	// Audio thread: returns the newest finished evaluation or nullptr if there is none
+	const Result* fetch(Job job) {
+		if (!jobs[job].results.update()) return nullptr;
+		return &jobs[job].results.readBuffer();
+	}
+
+	// Request a new curve table for the given base positions. Only the latest request per job is built.
+	void requestCurveTable(Job job, const Positions& basePositions, int dim, uint64_t generation) {
+		Request& r = tableJobs[job].requests.writeBuffer();
+		r.positions = basePositions;
+		r.dim = dim;
+		r.generation = generation;
+		tableJobs[job].requests.publish();
+		notify();
+	}
+
+	// Audio thread: returns the newest finished curve table or nullptr if there is none. The table
+	// stays valid until the next call of this function for the same job.
+	const CurveTable* fetchCurveTable(Job job) {
+		if (!tableJobs[job].results.update()) return nullptr;
+		return &tableJobs[job].results.readBuffer();
+	}
+
+private:
+	struct Request
+	{
+		Positions positions;
+		int dim;
+		uint64_t generation;
+	};
+
+	struct JobBuffers
+	{
+		TripleBuffer<Request> requests;
+		TripleBuffer<Result> results;
+	};
+
+	struct TableJobBuffers
+	{
+		TripleBuffer<Request> requests;
+		TripleBuffer<CurveTable> results;
+	};
+
+	// Wakes the worker if it is not already about to run (never blocks)
+	void notify() {
+		if (!pending.exchange(true, std::memory_order_acq_rel)) wakeup.post();
+	}
+
+	void run() {
+		while (!quit) {
+			if (pending.exchange(false, std::memory_order_acq_rel)) {
+				processPositionJobs();
+				for (int job = 0; job < numJobs; job++) {
+					buildCurveTable(static_cast<Job>(job));
+				}
+			}
+			wakeup.wait();
+		}
+	}
+
+	void processPositionJobs() {
+		for (int j = 0; j < numJobs; j++) {
+			auto& job = jobs[j];
+			if (!job.requests.update()) continue;
+			const Request& r = job.requests.readBuffer();
+			Result& result = job.results.writeBuffer();
+			evaluator.setDim(r.dim);
+			for (int ch = 0; ch < numPositions(static_cast<Job>(j)); ch++) {
+				evaluator.eigenFunctions(r.positions[ch], result.ef[ch].data(), N);
+			}
+			result.dim = r.dim;
+			result.generation = r.generation;
+			job.results.publish();
+		}
+	}
+
+	void buildCurveTable(Job job) {
+		auto& buffers = tableJobs[job];
+		if (!curve || !buffers.requests.update()) return;
+		const Request& r = buffers.requests.readBuffer();
+		CurveTable& table = buffers.results.writeBuffer();
+		table.values.resize(numPositions(job));
+		for (int k = 0; k <= curveTableSize; k++) {
+			// single position requests are more urgent, don't let them wait for the whole table
+			processPositionJobs();
+			if (quit) return;
+
+			const SpaceVec offset = curve(job, static_cast<double>(k) / curveTableSize);
+			evaluator.setDim(r.dim);
+			for (int ch = 0; ch < numPositions(job); ch++) {
+				SpaceVec x = r.positions[ch];
+				x += offset;
+				evaluator.eigenFunctions(x, scratch.data(), N);
+				for (int i = 0; i < N; i++) {
+					table.values[ch][k][i] = scratch[i].real();
+				}
+			}
+		}
+		table.dim = r.dim;
+		table.generation = r.generation;
+		buffers.results.publish();
+	}
+
+	EigenValues evaluator;
+	std::array<JobBuffers, numJobs> jobs;
+	std::array<TableJobBuffers, numJobs> tableJobs;
+	std::array<typename Resonator::scalar, N> scratch;
+	Curve curve;
+
+	std::thread thread;
+	Semaphore wakeup;
+	std::atomic<bool> pending{ false }; // there are new requests, wakeup has been posted
+	std::atomic<bool> quit{ false };
+};
+
+} // namespace ResonatorPlugin
+} // namespace Uberton
@@ -0,0 +1,155 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <simd_math.h>
+#include <limiter.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace Uberton {
+namespace ResonatorPlugin {
+
+enum class LimiterMode {
+	Off,
+	SoftClip,
+	Lookahead
+};
+
+//
+// Output stage after the resonator for one block:
+//
+//   out = limit(wetGain·filter(wet) + dryGain·dry)
+//
+// with limit = tanh (SoftClip) or a lookahead brickwall limiter (Lookahead). The filter (a stereo low cut + high cut cascade) runs in place on
+// the wet buffer with all channels and stages in one SIMD register. Multichannel outputs use one
+// filter per channel pair. Afterwards, a single vectorized
+// pass per channel mixes, limits and writes the output. While the result is written, the peak and
+// the energy of the block are accumulated, which gives the meter values and the silence flag
+// without reading the output again.
+//
+// In Lookahead mode the mix is written back to the wet buffer and fed to the limiter. The pass
+// that writes the output then applies the limiter gains to the delayed signal and does the metering.
+//
+// The gains are either constant for the block or per-sample ramps (see ParameterSmoothers), which
+// are read in the same pass.
+//
+// The dry signal may be the same buffer as the output (in-place processing), each sample is read
+// before it is overwritten.
+//
+template<class SampleType, class Filter, int maxBlockSize, int maxChannels = 2>
+class OutputStage
+{
+public:
+	using Vec = Simd::Vec<SampleType>;
+	static constexpr int lanes = Vec::size;
+	using Limiter = LookaheadLimiter<SampleType, maxChannels, maxBlockSize>;
+
+	// Same threshold as ProcessorBase::checkSilence()
+	static constexpr SampleType silenceThreshold = SampleType(0.0001);
+
+	struct Levels
+	{
+		SampleType peakSq{ 0 };
+		SampleType sumSq{ 0 };
+		int numSamples{ 0 };
+
+		SampleType peak() const { return std::sqrt(peakSq); }
+		SampleType rms() const { return numSamples > 0 ? std::sqrt(sumSq / numSamples) : 0; }
+		bool isSilent() const { return peakSq <= silenceThreshold * silenceThreshold; }
+	};
+
+	struct Gains
+	{
+		SampleType wet;
+		SampleType dry;
+		const SampleType* wetRamp{ nullptr }; // per-sample gains (maxBlockSize entries), used instead of wet if set
+		const SampleType* dryRamp{ nullptr };
+
+		Vec wetAt(int i) const { return wetRamp ? Vec::load(wetRamp + i) : Vec(wet); }
+		Vec dryAt(int i) const { return dryRamp ? Vec::load(dryRamp + i) : Vec(dry); }
+	};
+
+	// wet is filtered in place with filters[ch / 2], numChannels ≤ maxChannels, numSamples ≤ maxBlockSize
+	static void process(SampleType* const* wet, const SampleType* const* dry, SampleType* const* out, int numChannels, int numSamples, Filter* filters, Gains gains, LimiterMode mode, Limiter& limiter, Levels* levels) {
+		for (int ch = 0; ch < numChannels; ch += 2) {
+			filters[ch / 2].processBlock(wet[ch], ch + 1 < numChannels ? wet[ch + 1] : nullptr, numSamples);
+		}
+		if (mode != LimiterMode::Lookahead) {
+			for (int ch = 0; ch < numChannels; ch++) {
+				run(wet[ch], dry[ch], out[ch], numSamples, levels[ch], [&](Vec w, Vec d, int i) {
+					const Vec y = w * gains.wetAt(i) + d * gains.dryAt(i);
+					return mode == LimiterMode::SoftClip ? Simd::tanh(y) : y;
+				});
+			}
+			return;
+		}
+
+		for (int ch = 0; ch < numChannels; ch++) {
+			Levels unused;
+			run(wet[ch], dry[ch], wet[ch], numSamples, unused, [&](Vec w, Vec d, int i) { return w * gains.wetAt(i) + d * gains.dryAt(i); });
+		}
+		limiter.process(wet, numChannels, numSamples);
+		for (int ch = 0; ch < numChannels; ch++) {
+			run(limiter.delayed(ch), limiter.gains(), out[ch], numSamples, levels[ch], [](Vec x, Vec g, int) { return x * g; });
+		}
+		limiter.advance();
+	}
+
+private:
+	// out[i] = f(a[i], b[i], i) in one vectorized pass with metering. The tail is passed with the
+	// index of its first sample, so ramps need to be readable up to a multiple of the vector size.
+	template<class F>
+	static void run(const SampleType* a, const SampleType* b, SampleType* out, int numSamples, Levels& levels, F&& f) {
+		Vec peakSq(SampleType(0));
+		Vec sumSq(SampleType(0));
+
+		auto step = [&](const SampleType* aIn, const SampleType* bIn, int index) {
+			const Vec y = f(Vec::load(aIn), Vec::load(bIn), index);
+			const Vec sq = y * y;
+			peakSq = max(peakSq, sq);
+			sumSq = sumSq + sq;
+			return y;
+		};
+
+		int i = 0;
+		for (; i + lanes <= numSamples; i += lanes) {
+			step(a + i, b + i, i).store(out + i);
+		}
+		if (i < numSamples) {
+			// tail: zero padding contributes neither to peak nor to energy
+			SampleType aTail[lanes]{}, tail[lanes]{};
+			const int count = numSamples - i;
+			for (int k = 0; k < count; k++) {
+				aTail[k] = a[i + k];
+				tail[k] = b[i + k];
+			}
+			step(aTail, tail, i).store(tail);
+			for (int k = 0; k < count; k++) {
+				out[i + k] = tail[k];
+			}
+		}
+
+		SampleType peakLanes[lanes], sumLanes[lanes];
+		peakSq.store(peakLanes);
+		sumSq.store(sumLanes);
+		for (int k = 0; k < lanes; k++) {
+			levels.peakSq = std::max(levels.peakSq, peakLanes[k]);
+			levels.sumSq += sumLanes[k];
+		}
+		levels.numSamples += numSamples;
+	}
+};
+
+} // namespace ResonatorPlugin
+} // namespace Uberton
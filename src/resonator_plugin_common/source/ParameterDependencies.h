@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+
+namespace Uberton {
+namespace ResonatorPlugin {
+
+//
+// Declarative dependency graph between parameters and derived (processing) state.
+//
+// Each parameter invalidates one or more nodes of derived state and nodes can depend on other
+// nodes. While the parameter queues are drained, invalidate() only marks nodes as dirty. The
+// dirty nodes are recomputed afterwards with recompute(), each exactly once and in dependency
+// order, regardless of how many of their parameters changed.
+//
+// Nodes are identified by indices 0...numNodes-1 and a node may only depend on nodes with a
+// lower index, so the index order is a valid topological order.
+//
+// Usage:
+//   deps.addParameter(kParamFreq, kStateFrequency);
+//   deps.addDependency(kStateDimension, kStatePositions); // positions depend on dimension
+//   ...
+//   deps.invalidate(id);                              // for each changed parameter
+//   deps.recompute([](int node, Mask dirty) { ... }); // once per block
+//
+template<int numParams, int numNodes>
+class ParameterDependencies
+{
+	static_assert(numNodes <= 32, "node masks are 32 bit wide");
+
+public:
+	using Mask = uint32_t;
+
+	static constexpr Mask bit(int node) { return Mask{ 1 } << node; }
+	static constexpr Mask allNodes() { return numNodes == 32 ? ~Mask{ 0 } : bit(numNodes) - 1; }
+
+	/// Parameter id invalidates node
+	void addParameter(int id, int node) {
+		assert(id >= 0 && id < numParams && node >= 0 && node < numNodes);
+		directNodes[id] |= bit(node);
+		update();
+	}
+
+	/// All parameters in [firstId, lastId] invalidate node
+	void addParameterRange(int firstId, int lastId, int node) {
+		for (int id = firstId; id <= lastId; id++) {
+			addParameter(id, node);
+		}
+	}
+
+	/// Node dependent needs to be recomputed whenever node is
+	void addDependency(int node, int dependent) {
+		assert(node < dependent && dependent < numNodes);
+		dependents[node] |= bit(dependent);
+		update();
+	}
+
+	void invalidate(int id) {
+		if (id >= 0 && id < numParams) {
+			dirty |= paramNodes[id];
+		}
+	}
+
+	void invalidateNode(int node) { dirty |= closure[node]; }
+	void invalidateAll() { dirty = allNodes(); }
+
+	/// Mark nodes as up to date (i.e. when their state has been set by other means)
+	void validate(Mask nodes) { dirty &= ~nodes; }
+
+	bool isDirty(int node) const { return (dirty & bit(node)) != 0; }
+	Mask dirtyNodes() const { return dirty; }
+
+	/// Calls f(node, dirtyMask) for each dirty node in dependency order and clears all flags.
+	/// dirtyMask contains all nodes that are recomputed in this pass.
+	template<class F>
+	void recompute(F&& f) {
+		const Mask nodes = dirty;
+		dirty = 0;
+		for (int node = 0; node < numNodes; node++) {
+			if (nodes & bit(node)) {
+				f(node, nodes);
+			}
+		}
+	}
+
+private:
+	// precompute transitive closure so that invalidate() is a single lookup
+	void update() {
+		for (int node = numNodes - 1; node >= 0; node--) {
+			closure[node] = bit(node);
+			for (int dependent = node + 1; dependent < numNodes; dependent++) {
+				if (dependents[node] & bit(dependent)) {
+					closure[node] |= closure[dependent];
+				}
+			}
+		}
+		for (int id = 0; id < numParams; id++) {
+			paramNodes[id] = 0;
+			for (int node = 0; node < numNodes; node++) {
+				if (directNodes[id] & bit(node)) {
+					paramNodes[id] |= closure[node];
+				}
+			}
+		}
+	}
+
+	std::array<Mask, numParams> directNodes{};
+	std::array<Mask, numParams> paramNodes{};
+	std::array<Mask, numNodes> dependents{};
+	std::array<Mask, numNodes> closure{};
+	Mask dirty{ 0 };
+};
+
+} // namespace ResonatorPlugin
+} // namespace Uberton
@@ -0,0 +1,356 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "common_param_specs.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace Uberton {
+namespace ResonatorPlugin {
+
+// Resonator settings of a parameter state (in scaled units)
+struct ResonatorSettings
+{
+	int dim;
+	int order;
+	float freq;
+	float damp;
+	float vel;
+};
+
+//
+// Cache of the modal state (time steps and eigenfunction weights) of the parameter states loaded
+// with setState().
+//
+// Recalling a preset changes the dimension, the frequency and all positions at once. Evaluating
+// the eigenfunctions for all positions and the time steps on the audio thread in one block is
+// expensive enough to cause dropouts. The bank evaluates them when the state is loaded, before it
+// is transferred to the audio thread: right away with prepare() if the processor is active, or on
+// a background thread with preload() if it is not (a host restoring a project should not wait
+// for eigen data). Switching back to a state that has been loaded before is then a cache hit. The
+// audio thread looks up the parameter state with acquire() and only copies the precomputed arrays
+// into the resonator.
+//
+// Slots are keyed by the parameters that determine the modal state (resonator settings, positions
+// and position curves) and a hash of them, so the audio thread compares one integer per slot.
+//
+// The bank has a fixed number of slots, the least recently prepared preset is replaced. Slots are
+// assigned under a mutex. The evaluating thread (UI or worker) claims a slot, copies its inputs
+// and evaluates them without the lock into its own scratch state, which is published under the
+// lock unless the slot has been replaced in the meantime. So the lock is only held for copying,
+// prepare() only waits if the worker is evaluating the same state. The audio thread never locks:
+// it announces the slot it is reading in inUse and only reads slots that are Ready. A slot that is
+// replaced is retired (set to Empty) first. If the audio thread is still reading it, it stays
+// retired and the next least recently used slot is taken instead, nobody waits.
+//
+// Usage:
+//   bank.setSampleRate(sampleRate);                                // not real-time safe
+//   bank.prepare(state, settings, inputPositions, outputPositions); // UI thread
+//   bank.preload(state, settings, inputPositions, outputPositions); // UI thread, starts the worker
+//   if (const auto* modes = bank.acquire(paramState)) {             // audio thread
+//     ... copy modes->timeFunctions, modes->inputEF, modes->outputEF ...
+//     bank.release();
+//   }
+//
+template<class Resonator, int numSlots = 16>
+class PresetBank
+{
+public:
+	using real = typename Resonator::real;
+	using scalar = typename Resonator::scalar;
+	using SpaceVec = typename Resonator::SpaceVec;
+	static constexpr int N = Resonator::maxOrder();
+	using Positions = std::array<SpaceVec, std::max(Resonator::numChannels(), Resonator::numOutputChannels())>;
+
+	struct ModalState
+	{
+		ResonatorSettings settings;
+		std::array<scalar, N> timeFunctions;
+		typename Resonator::EFArray inputEF;
+		typename Resonator::OutputEFArray outputEF;
+	};
+
+	PresetBank() = default;
+	PresetBank(const PresetBank&) = delete;
+	PresetBank& operator=(const PresetBank&) = delete;
+	~PresetBank() { stop(); }
+
+	// Drops all presets
+	void setSampleRate(real newSampleRate) {
+		std::lock_guard<std::mutex> lock(mutex);
+		sampleRate = newSampleRate;
+		for (int s = 0; s < numSlots; s++) {
+			retire(s);
+		}
+	}
+
+	void start() {
+		if (thread.joinable()) return;
+		quit = false;
+		thread = std::thread([this] { run(); });
+	}
+
+	void stop() {
+		if (!thread.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit.store(true);
+		}
+		condition.notify_all();
+		thread.join();
+	}
+
+	// Evaluate the modal state of a parameter state now (if it is not in the bank yet)
+	void prepare(const ParamState& state, const ResonatorSettings& settings, const Positions& inputPositions, const Positions& outputPositions) {
+		std::unique_lock<std::mutex> lock(mutex);
+		const int s = assign(state, settings, inputPositions, outputPositions);
+		if (s == noSlot) return;
+		// the worker may be evaluating this state right now
+		condition.wait(lock, [&] { return slots[s].status.load() != Building; });
+		if (slots[s].status.load() != Pending) return;
+
+		const Job job = claim(s);
+		lock.unlock();
+		build(job, uiResonator, uiModes);
+		lock.lock();
+		publish(job, uiModes);
+	}
+
+	// Evaluate the modal state of a parameter state on the worker thread (started on first use)
+	void preload(const ParamState& state, const ResonatorSettings& settings, const Positions& inputPositions, const Positions& outputPositions) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			assign(state, settings, inputPositions, outputPositions);
+		}
+		start();
+		condition.notify_all();
+	}
+
+	// Audio thread: the modal state of the parameter state or nullptr if it is not ready. The
+	// result stays valid until release() is called.
+	const ModalState* acquire(const ParamState& state) {
+		const Key key = keyOf(state);
+		for (int s = 0; s < numSlots; s++) {
+			if (slots[s].hash.load(std::memory_order_relaxed) != key.hash) continue;
+			inUse.store(s);
+			if (slots[s].status.load() == Ready && slots[s].key == key) {
+				return &slots[s].modes;
+			}
+		}
+		inUse.store(noSlot);
+		return nullptr;
+	}
+
+	// Audio thread: done with the result of acquire()
+	void release() { inUse.store(noSlot); }
+
+private:
+	enum Status {
+		Empty,
+		Pending,  // waiting to be evaluated
+		Building, // claimed by the UI thread or the worker
+		Ready
+	};
+
+	// Parameters of the modal state (ranges of parameter ids, inclusive)
+	static constexpr std::array<std::array<ParamID, 2>, 4> modalParams{ {
+		{ kParamResonatorDim, kParamResonatorVel },
+		{ kParamInL0, kParamOutRN },
+		{ kParamInPosCurveL, kParamLinkOutPosCurves },
+		{ kParamOutSurround0, kParamOutSurroundN },
+	} };
+
+	static constexpr int numModalParams() {
+		int n = 0;
+		for (const auto& range : modalParams) n += range[1] - range[0] + 1;
+		return n;
+	}
+
+	struct Key
+	{
+		uint64_t hash{ 0 };
+		std::array<ParamValue, numModalParams()> values{};
+
+		bool operator==(const Key& other) const { return hash == other.hash && values == other.values; }
+	};
+
+	static Key keyOf(const ParamState& state) {
+		Key key;
+		uint64_t hash = 14695981039346656037ull; // FNV-1a over the 64 bit words
+		int i = 0;
+		for (const auto& range : modalParams) {
+			for (ParamID id = range[0]; id <= range[1]; id++) {
+				const ParamValue value = state[id];
+				uint64_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				hash = (hash ^ bits) * 1099511628211ull;
+				key.values[i++] = value;
+			}
+		}
+		key.hash = hash ^ (hash >> 32);
+		return key;
+	}
+
+	struct Slot
+	{
+		Key key{};
+		std::atomic<uint64_t> hash{ 0 }; // copy of key.hash for the audio thread
+		Positions inputPositions{};
+		Positions outputPositions{};
+		ModalState modes{};
+		std::atomic<int> status{ Empty };
+		uint64_t lastUse{ 0 };
+		uint64_t assignment{ 0 }; // changes whenever the slot is assigned to another state
+	};
+
+	// Inputs of a claimed slot, evaluated without the lock
+	struct Job
+	{
+		int slot;
+		uint64_t assignment;
+		ResonatorSettings settings;
+		Positions inputPositions;
+		Positions outputPositions;
+		real sampleRate;
+	};
+
+	static constexpr int noSlot = -1;
+	static_assert(numSlots <= 32, "slots are tracked in a 32 bit mask");
+
+	// Find the slot of a state or replace the least recently used one that the audio thread is not
+	// reading, noSlot if there is none (mutex needs to be held)
+	int assign(const ParamState& state, const ResonatorSettings& settings, const Positions& inputPositions, const Positions& outputPositions) {
+		const Key key = keyOf(state);
+		for (int k = 0; k < numSlots; k++) {
+			if (slots[k].status.load() != Empty && slots[k].key == key) {
+				slots[k].lastUse = ++useCounter;
+				return k;
+			}
+		}
+
+		// the audio thread reads at most one slot at a time, so this rarely takes a second round
+		uint32_t tried = 0;
+		int s = noSlot;
+		for (int round = 0; round < numSlots && s == noSlot; round++) {
+			int candidate = noSlot;
+			for (int k = 0; k < numSlots; k++) {
+				if (tried & (1u << k)) continue;
+				if (candidate == noSlot || slots[k].lastUse < slots[candidate].lastUse) candidate = k;
+			}
+			tried |= 1u << candidate;
+			if (retire(candidate)) s = candidate;
+		}
+		if (s == noSlot) return noSlot;
+
+		Slot& slot = slots[s];
+		slot.key = key;
+		slot.hash.store(key.hash, std::memory_order_relaxed);
+		slot.modes.settings = settings;
+		slot.inputPositions = inputPositions;
+		slot.outputPositions = outputPositions;
+		slot.lastUse = ++useCounter;
+		slot.assignment = ++assignmentCounter;
+		slot.status.store(Pending);
+		return s;
+	}
+
+	// Take a slot away from the audio thread, true if it may be overwritten right away (mutex needs
+	// to be held). After the status is Empty, the audio thread does not start reading the slot
+	// anymore, so unless it is still announced in inUse, nobody reads it.
+	bool retire(int s) {
+		slots[s].status.store(Empty);
+		slots[s].lastUse = 0;
+		return inUse.load() != s;
+	}
+
+	// Take a pending slot for evaluation (mutex needs to be held)
+	Job claim(int s) {
+		Slot& slot = slots[s];
+		slot.status.store(Building);
+		return { s, slot.assignment, slot.modes.settings, slot.inputPositions, slot.outputPositions, sampleRate };
+	}
+
+	// Evaluate a claimed slot with the resonator and the scratch state of the calling thread (without
+	// the mutex)
+	static void build(const Job& job, Resonator& resonator, ModalState& modes) {
+		const ResonatorSettings& settings = job.settings;
+		resonator.setSampleRate(job.sampleRate);
+		resonator.setDim(settings.dim);
+		resonator.setFreqDampeningAndVelocity(settings.freq, settings.damp, settings.vel);
+		resonator.setInputPositions(job.inputPositions);
+		resonator.setOutputPositions(job.outputPositions);
+		modes.settings = settings;
+		modes.timeFunctions = resonator.timeFunctions;
+		modes.inputEF = resonator.inputPosEF;
+		modes.outputEF = resonator.outputPosEF;
+	}
+
+	// Store the result of a job unless the slot has been retired or replaced while it was evaluated
+	// (mutex needs to be held). The audio thread does not read slots that are not Ready.
+	void publish(const Job& job, const ModalState& modes) {
+		Slot& slot = slots[job.slot];
+		if (slot.status.load() != Building || slot.assignment != job.assignment) return;
+		slot.modes = modes;
+		slot.status.store(Ready);
+	}
+
+	// (mutex needs to be held)
+	bool hasPending() const {
+		return std::any_of(slots.begin(), slots.end(), [](const Slot& slot) { return slot.status.load() == Pending; });
+	}
+
+	void run() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			condition.wait(lock, [this] { return quit || hasPending(); });
+			if (quit) break;
+			int s = 0;
+			while (slots[s].status.load() != Pending) s++;
+
+			const Job job = claim(s);
+			lock.unlock();
+			build(job, workerResonator, workerModes);
+			lock.lock();
+			publish(job, workerModes);
+			condition.notify_all(); // prepare() may wait for this slot
+		}
+	}
+
+	std::array<Slot, numSlots> slots;
+	std::atomic<int> inUse{ noSlot }; // slot read by the audio thread
+	uint64_t useCounter{ 0 };
+	uint64_t assignmentCounter{ 0 };
+	real sampleRate{ 44100 };
+
+	// the resonators and scratch states are only used to evaluate presets, each thread has its own
+	Resonator uiResonator;
+	Resonator workerResonator;
+	ModalState uiModes;
+	ModalState workerModes;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::atomic<bool> quit{ false };
+};
+
+} // namespace ResonatorPlugin
+} // namespace Uberton
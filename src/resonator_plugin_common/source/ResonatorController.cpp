@@ -11,11 +11,13 @@
 
 #include "ResonatorController.h"
 #include <subcontrollers.h>
+#include <scan_timer.h>
 
 namespace Uberton {
 namespace ResonatorPlugin {
 
 tresult PLUGIN_API ResonatorController::initialize(FUnknown* context) {
+	UBERTON_SCAN_TIMER("ResonatorController::initialize");
 
 	tresult result = ControllerBase::initialize(context);
 	if (result != kResultTrue) return result;
@@ -31,6 +33,8 @@ tresult PLUGIN_API ResonatorController::initialize(FUnknown* context) {
 	addUnit(new Unit(USTRING("Output Position"), outputPositionUnitId, rootUnitId));
 	UnitID postSectionUnitId = 4;
 	addUnit(new Unit(USTRING("Post Filter"), postSectionUnitId, rootUnitId));
+	UnitID surroundPositionUnitId = 5;
+	addUnit(new Unit(USTRING("Surround Output Position"), surroundPositionUnitId, outputPositionUnitId));
 
 
 
@@ -59,6 +63,7 @@ tresult PLUGIN_API ResonatorController::initialize(FUnknown* context) {
 		addParam<LinearParameter>(ParamSpecs::processTime, "Process Time", "T", "", Precision(6), ParameterInfo::kIsReadOnly);
 
 		addStringListParam(ParamSpecs::limiterOn, "Output Limiter", "Out Lim", { "Off", "On" });
+		addStringListParam(ParamSpecs::limiterMode, "Output Limiter Mode", "Lim Mode", { "Soft Clip", "Lookahead" });
 		addParam<LinearParameter>(ParamSpecs::resonatorLength, "Resonator Length", "Res Len", "m", Precision(3), ParameterInfo::kIsReadOnly);
 	}
 
@@ -97,7 +102,23 @@ tresult PLUGIN_API ResonatorController::initialize(FUnknown* context) {
 			name.append(a);
 			addRangeParam(Params::kParamOutR0 + i, name, "", { 0, 1, .5 });
 		}
+		// surround channels (numbered from 3, as channel 1 and 2 are left and right)
+		setCurrentUnitID(surroundPositionUnitId);
+		UString256 channelNumber("", 10);
+		for (int ch = 2; ch < maxOutputChannels; ch++) {
+			channelNumber.printInt(ch + 1);
+			for (int i = 0; i < maxDimension; i++) {
+				a.printInt(i);
+				UString256 name("Out ");
+				name.append(channelNumber);
+				name.append(UString256(" Y"));
+				name.append(a);
+				addRangeParam(outputPositionParam(ch, i), name, "", { 0, 1, .5 });
+			}
+		}
 	}
+	// until the processor reports its bus arrangement
+	setNumOutputChannels(2);
 
 	return kResultTrue;
 }
@@ -108,20 +129,57 @@ tresult PLUGIN_API ResonatorController::notify(IMessage* message) {
 		parameters.getParameter(Params::kParamVUPPM_R)->setNormalized(0);
 		return kResultTrue;
 	}
+	if (FIDStringsEqual(message->getMessageID(), outputChannelsMsgID)) {
+		int64 numChannels;
+		if (message->getAttributes()->getInt(numOutputChannelsAttr, numChannels) == kResultOk) {
+			setNumOutputChannels(static_cast<int>(numChannels));
+		}
+		return kResultTrue;
+	}
 	return ControllerBase<ParamState, ImplementBypass>::notify(message);
 }
 
 tresult PLUGIN_API ResonatorController::setParamNormalized(ParamID tag, ParamValue value) {
+	const bool hadLatency = hasLimiterLatency();
 	auto result = ControllerBase<ParamState, ImplementBypass>::setParamNormalized(tag, value);
 	switch (tag) {
 	case Params::kParamResonatorFreq:
 	case Params::kParamResonatorDim:
 	case Params::kParamResonatorDamp:
 		updateResonatorSizeDisplay();
+		break;
+	case Params::kParamLimiterOn:
+	case Params::kParamLimiterMode:
+		// the lookahead limiter adds latency
+		if (hasLimiterLatency() != hadLatency && componentHandler) {
+			componentHandler->restartComponent(kLatencyChanged);
+		}
+		break;
 	}
 	return result;
 }
 
+bool ResonatorController::hasLimiterLatency() {
+	return getParamNormalized(Params::kParamLimiterOn) != 0 && getParamNormalized(Params::kParamLimiterMode) != 0;
+}
+
+void ResonatorController::setNumOutputChannels(int numChannels) {
+	bool changed = false;
+	for (int ch = 2; ch < maxOutputChannels; ch++) {
+		const int32 flags = ch < numChannels ? ParameterInfo::kCanAutomate : ParameterInfo::kIsReadOnly | ParameterInfo::kIsHidden;
+		for (int i = 0; i < maxDimension; i++) {
+			ParameterInfo& info = parameters.getParameter(outputPositionParam(ch, i))->getInfo();
+			if (info.flags != flags) {
+				info.flags = flags;
+				changed = true;
+			}
+		}
+	}
+	if (changed && componentHandler) {
+		componentHandler->restartComponent(kParamTitlesChanged);
+	}
+}
+
 tresult PLUGIN_API ResonatorController::setComponentState(IBStream* state) {
 	auto result = ControllerBase<ParamState, ImplementBypass>::setComponentState(state);
 	updateResonatorSizeDisplay();
@@ -28,6 +28,10 @@ public:
 	tresult PLUGIN_API setComponentState(IBStream* state) SMTG_OVERRIDE;
 
 	virtual void updateResonatorSizeDisplay() = 0;
+	// same condition as the LimiterMode::Lookahead of the processor
+	bool hasLimiterLatency();
+	// hides the position parameters of surround channels beyond numChannels
+	void setNumOutputChannels(int numChannels);
 };
 }
 }
\ No newline at end of file
@@ -43,6 +43,7 @@ ResonatorProcessorBase::ResonatorProcessorBase() {
 	initValue(ParamSpecs::hcFreq);
 	initValue(ParamSpecs::hcQ);
 	initValue(ParamSpecs::limiterOn);
+	initValue(ParamSpecs::limiterMode);
 
 	for (int i = 0; i < maxDimension; i++) {
 		paramState[Params::kParamInL0 + i] = .5;
@@ -50,9 +51,39 @@ ResonatorProcessorBase::ResonatorProcessorBase() {
 		paramState[Params::kParamOutL0 + i] = .5;
 		paramState[Params::kParamOutR0 + i] = .5;
 	}
+	for (int ch = 2; ch < maxOutputChannels; ch++) {
+		for (int i = 0; i < maxDimension; i++) {
+			paramState[outputPositionParam(ch, i)] = .5;
+		}
+	}
+
+	dependencies.addParameter(Params::kParamResonatorDim, kStateDimension);
+	dependencies.addParameter(Params::kParamResonatorOrder, kStateOrder);
+	dependencies.addParameter(Params::kParamResonatorFreq, kStateFrequency);
+	dependencies.addParameter(Params::kParamResonatorDamp, kStateFrequency);
+	dependencies.addParameter(Params::kParamResonatorVel, kStateFrequency);
+	dependencies.addParameterRange(Params::kParamInL0, Params::kParamInRN, kStateInputPositions);
+	dependencies.addParameter(Params::kParamInPosCurveL, kStateInputPositions);
+	dependencies.addParameter(Params::kParamInPosCurveR, kStateInputPositions);
+	dependencies.addParameterRange(Params::kParamOutL0, Params::kParamOutRN, kStateOutputPositions);
+	dependencies.addParameterRange(Params::kParamOutSurround0, Params::kParamOutSurroundN, kStateOutputPositions);
+	dependencies.addParameter(Params::kParamOutPosCurveL, kStateOutputPositions);
+	dependencies.addParameter(Params::kParamOutPosCurveR, kStateOutputPositions);
+	dependencies.addParameter(Params::kParamLCFreq, kStateLowCut);
+	dependencies.addParameter(Params::kParamLCQ, kStateLowCut);
+	dependencies.addParameter(Params::kParamHCFreq, kStateHighCut);
+	dependencies.addParameter(Params::kParamHCQ, kStateHighCut);
+	dependencies.addParameter(Params::kParamVol, kStateLevels);
+	dependencies.addParameter(Params::kParamMix, kStateLevels);
+	dependencies.addParameter(Params::kParamLimiterOn, kStateLevels);
+	dependencies.addParameter(Params::kParamLimiterMode, kStateLevels);
+	// the eigenfunctions belong to other modes after a dimension change
+	dependencies.addDependency(kStateDimension, kStateInputPositions);
+	dependencies.addDependency(kStateDimension, kStateOutputPositions);
 }
 
 tresult PLUGIN_API ResonatorProcessorBase::initialize(FUnknown* context) {
+	UBERTON_SCAN_TIMER("ResonatorProcessorBase::initialize");
 	tresult result = ProcessorBase::initialize(context);
 	if (result != kResultTrue)
 		return kResultFalse;
@@ -64,11 +95,76 @@ tresult PLUGIN_API ResonatorProcessorBase::initialize(FUnknown* context) {
 }
 
 tresult PLUGIN_API ResonatorProcessorBase::setBusArrangements(SpeakerArrangement* inputs, int32 numIns, SpeakerArrangement* outputs, int32 numOuts) {
-	// Only support stereo in/stereo out
-	if (numIns == 1 && numOuts == 1 && inputs[0] == SpeakerArr::kStereo && inputs[0] == outputs[0]) {
-		return ProcessorBase::setBusArrangements(inputs, numIns, outputs, numOuts);
+	// Support mono in/mono out, mono in/stereo out and stereo in/stereo, 5.1, 7.1 or 7.1.4 out
+	if (numIns != 1 || numOuts != 1) return kResultFalse;
+
+	Configuration newConfiguration;
+	if (inputs[0] == SpeakerArr::kMono && outputs[0] == SpeakerArr::kMono)
+		newConfiguration = Configuration::Mono;
+	else if (inputs[0] == SpeakerArr::kMono && outputs[0] == SpeakerArr::kStereo)
+		newConfiguration = Configuration::MonoToStereo;
+	else if (inputs[0] == SpeakerArr::kStereo && outputs[0] == SpeakerArr::kStereo)
+		newConfiguration = Configuration::Stereo;
+	else if (inputs[0] == SpeakerArr::kStereo && outputs[0] == SpeakerArr::k51)
+		newConfiguration = Configuration::Surround51;
+	else if (inputs[0] == SpeakerArr::kStereo && (outputs[0] == SpeakerArr::k71Cine || outputs[0] == SpeakerArr::k71Music))
+		newConfiguration = Configuration::Surround71;
+	else if (inputs[0] == SpeakerArr::kStereo && outputs[0] == SpeakerArr::k71_4)
+		newConfiguration = Configuration::Surround714;
+	else
+		return kResultFalse;
+
+	// ProcessorBase only accepts equal in- and output arrangements
+	tresult result = AudioEffect::setBusArrangements(inputs, numIns, outputs, numOuts);
+	if (result == kResultTrue) {
+		configuration = newConfiguration;
 	}
-	return kResultFalse;
+	return result;
+}
+
+tresult PLUGIN_API ResonatorProcessorBase::setActive(TBool state) {
+	active = state;
+	if (!state) {
+		if (processorImpl) processorImpl->suspend();
+		sendMessageID(processorDeactivatedMsgID);
+		return kResultTrue;
+	}
+
+	// the controller hides the output positions of the channels that are not in use
+	if (IPtr<IMessage> message = owned(allocateMessage())) {
+		message->setMessageID(outputChannelsMsgID);
+		message->getAttributes()->setInt(numOutputChannelsAttr, numOutputChannels(configuration));
+		sendMessage(message);
+	}
+
+	if (!processorImpl || implConfiguration != configuration || implSampleSize != processSetup.symbolicSampleSize) {
+		processorImpl = makeProcessorImpl(processSetup.symbolicSampleSize);
+		processorImpl->init(processSetup.sampleRate);
+		implConfiguration = configuration;
+		implSampleSize = processSetup.symbolicSampleSize;
+		implSampleRate = processSetup.sampleRate;
+		recomputeParameters();
+		return kResultTrue;
+	}
+
+	// Re-activation: the eigenfunctions and filter settings are still valid. Parameter and state
+	// changes made while the processor was inactive are dirty and are applied by the next process().
+	if (implSampleRate != processSetup.sampleRate) {
+		processorImpl->setSampleRate(processSetup.sampleRate);
+		implSampleRate = processSetup.sampleRate;
+	}
+	processorImpl->reset();
+	processorImpl->resume();
+	vuPPM = 0;
+	return kResultTrue;
+}
+
+uint32 PLUGIN_API ResonatorProcessorBase::getLatencySamples() {
+	// limiterMode is only recomputed in processAudio(), which is skipped while bypassed, for
+	// parameter flushes and while inactive, so the parameters are checked directly.
+	const bool lookahead = paramState[Params::kParamLimiterOn] != 0 && paramState[Params::kParamLimiterMode] != 0;
+	if (!processorImpl || !lookahead) return 0;
+	return processorImpl->getLimiterLatency();
 }
 
 tresult PLUGIN_API ResonatorProcessorBase::canProcessSampleSize(int32 symbolicSampleSize) {
@@ -85,14 +181,18 @@ void ResonatorProcessorBase::processAudio(ProcessData& data) {
 	// Handle silence flags
 	{
 		if (data.inputs[0].silenceFlags != 0 && vuPPM < 0.0001) {
-			data.outputs[0].silenceFlags = data.inputs[0].silenceFlags;
+			const int32 inChannels = data.inputs[0].numChannels;
+			const int32 outChannels = data.outputs[0].numChannels;
+			if (inChannels == outChannels)
+				data.outputs[0].silenceFlags = data.inputs[0].silenceFlags;
+			else
+				data.outputs[0].silenceFlags = (uint64{ 1 } << outChannels) - 1;
 
 			uint32 sampleFramesSize = getSampleFramesSizeInBytes(processSetup, data.numSamples);
-			int32 numChannels = data.inputs[0].numChannels;
 			void** in = getChannelBuffersPointer(processSetup, data.inputs[0]);
 			void** out = getChannelBuffersPointer(processSetup, data.outputs[0]);
-			for (int32 i = 0; i < numChannels; ++i) {
-				if (in[i] != out[i]) {
+			for (int32 i = 0; i < outChannels; ++i) {
+				if (in[std::min(i, inChannels - 1)] != out[i]) {
 					memset(out[i], 0, sampleFramesSize);
 				}
 			}
@@ -101,7 +201,7 @@ void ResonatorProcessorBase::processAudio(ProcessData& data) {
 		data.outputs[0].silenceFlags = 0;
 	}
 
-	vuPPM = processorImpl->processAll(data, mix, volume, limiterOn);
+	vuPPM = processorImpl->processAll(data, mix, volume, limiterMode);
 
 	//std::chrono::duration<double> duration = steady_clock::now() - t0;
 	//addOutputPoint(data, kParamProcessTime, (duration.count() / data.numSamples) * 1000.0 / 10.0);
@@ -115,23 +215,53 @@ void ResonatorProcessorBase::processParameterChanges(IParameterChanges* inputPar
 			if (id == bypassId) {
 				setBypassed(value > 0.5);
 			} else {
-				paramState.params[id] = value;
-			}
-			if (id == Params::kParamInPosCurveL || id == Params::kParamInPosCurveR || (id >= Params::kParamInL0 && id <= Params::kParamInRN)) {
-				processorImpl->updateResonatorInputPosition(paramState);
-			}
-			if (id == Params::kParamOutPosCurveL || id == Params::kParamOutPosCurveR || (id >= Params::kParamOutL0 && id <= Params::kParamOutRN)) {
-				processorImpl->updateResonatorOutputPosition(paramState);
-			}
-			if (id == Params::kParamResonatorDim) {
-				updateResonatorDimension();
+				paramState.set(id, value);
 			}
 		}
 
 		);
 	});
-	if (inputParameterChanges && inputParameterChanges->getParameterCount() > 0)
-		recomputeInexpensiveParameters();
+	// the dirty parameters include the changes of a state transfer in process()
+	if (paramState.getGeneration() == processedGeneration) return;
+	processedGeneration = paramState.getGeneration();
+	paramState.forEachDirty([this](int32 id) { dependencies.invalidate(id); });
+	recallPreset();
+	recomputeDirtyState();
+}
+
+void ResonatorProcessorBase::recallPreset() {
+	constexpr Dependencies::Mask modalState = Dependencies::bit(kStateDimension) | Dependencies::bit(kStateOrder) | Dependencies::bit(kStateFrequency) | Dependencies::bit(kStateInputPositions) | Dependencies::bit(kStateOutputPositions);
+	if (!processorImpl || (dependencies.dirtyNodes() & modalState) == 0) return;
+	if (!processorImpl->recallPreset(paramState)) return;
+
+	const ResonatorSettings settings = resonatorSettings(paramState);
+	resonatorDim = settings.dim;
+	resonatorOrder = settings.order;
+	resonatorFreq = settings.freq;
+	resonatorDamp = settings.damp;
+	resonatorVel = settings.vel;
+	dependencies.validate(modalState);
+}
+
+ResonatorSettings ResonatorProcessorBase::resonatorSettings(const ParamState& state) const {
+	return {
+		dimensionOf(state),
+		orderOf(state),
+		static_cast<float>(ParamSpecs::resonatorFreq.toScaled(state[Params::kParamResonatorFreq])),
+		static_cast<float>(ParamSpecs::resonatorDamp.toScaled(state[Params::kParamResonatorDamp])),
+		static_cast<float>(ParamSpecs::resonatorVel.toScaled(state[Params::kParamResonatorVel]))
+	};
+}
+
+void ResonatorProcessorBase::prepareState(const ParamState& state) {
+	// The audio thread only needs to switch to the precomputed modal state (see recallPreset()).
+	// An inactive processor (i.e. while the host scans or restores a project) evaluates it in the
+	// background, setState() should not touch eigen data then.
+	if (!processorImpl) return;
+	if (active)
+		processorImpl->preparePreset(state, resonatorSettings(state));
+	else
+		processorImpl->preloadPreset(state, resonatorSettings(state));
 }
 
 void ResonatorProcessorBase::beforeBypass(ProcessData& data) {
@@ -141,37 +271,63 @@ void ResonatorProcessorBase::beforeBypass(ProcessData& data) {
 }
 
 void ResonatorProcessorBase::recomputeParameters() {
-	recomputeInexpensiveParameters();
-	updateResonatorDimension(); // also updates positions!
+	paramState.clearDirty();
+	dependencies.invalidateAll();
+	recomputeDirtyState();
 }
 
-void ResonatorProcessorBase::recomputeInexpensiveParameters() {
-	volume = toScaled(ParamSpecs::vol);
-	mix = paramState[Params::kParamMix];
-	//resonatorOrder = toDiscrete(ParamSpecs::resonatorOrder);
-	resonatorFreq = toScaled(ParamSpecs::resonatorFreq);
-	resonatorDamp = toScaled(ParamSpecs::resonatorDamp);
-	resonatorVel = toScaled(ParamSpecs::resonatorVel);
-	limiterOn = paramState[Params::kParamLimiterOn] != 0;
+void ResonatorProcessorBase::recomputeDirtyState() {
+	if (!processorImpl) return;
+	dependencies.recompute([this](int node, Dependencies::Mask dirtyNodes) {
+		recomputeState(node, dirtyNodes);
+	});
+}
 
-	// auto& f = processorImpl->resonator.timeFunctions;
-	// FDebugPrint("Out EF %i %i: %f, %f, %f, %f,%f, %f, %f, %f, %f, %f\n", resonatorDim, resonatorOrder, f[0].real(), f[1].real(), f[2].real(), f[3].real(), f[4].real(), f[5].real(), f[6].real(), f[7].real(), f[8].real(), f[9].real());
+void ResonatorProcessorBase::recomputeState(int node, Dependencies::Mask dirtyNodes) {
+	// After a dimension change the eigenfunctions are reevaluated right away. Otherwise position
+	// changes are evaluated in the background and crossfaded.
+	const bool dimensionChanged = (dirtyNodes & Dependencies::bit(kStateDimension)) != 0;
 
-	if (processorImpl) {
+	switch (node) {
+	case kStateDimension: updateResonatorDimension(); break;
+	case kStateOrder: updateResonatorOrder(); break;
+	case kStateFrequency:
+		resonatorFreq = toScaled(ParamSpecs::resonatorFreq);
+		resonatorDamp = toScaled(ParamSpecs::resonatorDamp);
+		resonatorVel = toScaled(ParamSpecs::resonatorVel);
 		processorImpl->setResonatorFreq(resonatorFreq, resonatorDamp, resonatorVel);
-		processorImpl->setResonatorOrder(resonatorOrder);
-		processorImpl->setLCFilterFreqAndQ(toScaled(ParamSpecs::lcFreq), toScaled(ParamSpecs::lcQ));
-		processorImpl->setHCFilterFreqAndQ(toScaled(ParamSpecs::hcFreq), toScaled(ParamSpecs::hcQ));
+		break;
+	case kStateInputPositions:
+		if (dimensionChanged)
+			processorImpl->updateResonatorInputPosition(paramState);
+		else
+			processorImpl->requestResonatorInputPosition(paramState);
+		break;
+	case kStateOutputPositions:
+		if (dimensionChanged)
+			processorImpl->updateResonatorOutputPosition(paramState);
+		else
+			processorImpl->requestResonatorOutputPosition(paramState);
+		break;
+	case kStateLowCut: processorImpl->setLCFilterFreqAndQ(toScaled(ParamSpecs::lcFreq), toScaled(ParamSpecs::lcQ)); break;
+	case kStateHighCut: processorImpl->setHCFilterFreqAndQ(toScaled(ParamSpecs::hcFreq), toScaled(ParamSpecs::hcQ)); break;
+	case kStateLevels:
+		volume = toScaled(ParamSpecs::vol);
+		mix = paramState[Params::kParamMix];
+		if (paramState[Params::kParamLimiterOn] == 0)
+			limiterMode = LimiterMode::Off;
+		else
+			limiterMode = paramState[Params::kParamLimiterMode] != 0 ? LimiterMode::Lookahead : LimiterMode::SoftClip;
+		break;
 	}
 }
 
+void ResonatorProcessorBase::updateResonatorOrder() {
+	processorImpl->setResonatorOrder(resonatorOrder);
+}
+
 void ResonatorProcessorBase::updateResonatorDimension() {
-	if (processorImpl) {
-		processorImpl->setResonatorDim(resonatorDim);
-		// Need to reevaluate all eigenfunctions
-		processorImpl->updateResonatorInputPosition(paramState);
-		processorImpl->updateResonatorOutputPosition(paramState);
-	}
+	processorImpl->setResonatorDim(resonatorDim);
 	//auto& f = processorImpl->resonator.inputPosEF[0];
 	//FDebugPrint("Out EF %i: %f, %f, %f, %f,%f, %f, %f, %f, %f, %f\n", resonatorDim, f[0].real(), f[1].real(), f[2].real(), f[3].real(), f[4].real(), f[5].real(), f[6].real(), f[7].real(), f[8].real(), f[9].real());
 }
@@ -14,6 +14,7 @@
 #include <ProcessorBase.h>
 #include "common_param_specs.h"
 #include "ResonatorProcessorImpl.h"
+#include "ParameterDependencies.h"
 
 namespace Uberton {
 namespace ResonatorPlugin {
@@ -25,27 +26,66 @@ public:
 	ResonatorProcessorBase();
 
 	tresult PLUGIN_API initialize(FUnknown* context) SMTG_OVERRIDE;
+	tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
 	tresult PLUGIN_API setBusArrangements(SpeakerArrangement* inputs, int32 numIns, SpeakerArrangement* outputs, int32 numOuts) SMTG_OVERRIDE;
 	tresult PLUGIN_API canProcessSampleSize(int32 symbolicSampleSize) SMTG_OVERRIDE;
+	uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
 
 	void processAudio(ProcessData& data) override;
 	void processParameterChanges(IParameterChanges* parameterChanges) override;
 	void beforeBypass(ProcessData& data) override;
+	void checkSilence(ProcessData& data) override {} // the output stage sets the silence flags in processAudio()
+	void prepareState(const ParamState& state) override;
 
 
 protected:
-	// Inexpensive parameter udpates
-	virtual void recomputeInexpensiveParameters();
+	// Derived state that depends on the parameters. A node may only depend on nodes above it.
+	enum DerivedState {
+		kStateDimension,
+		kStateOrder,
+		kStateFrequency,
+		kStateInputPositions,
+		kStateOutputPositions,
+		kStateLowCut,
+		kStateHighCut,
+		kStateLevels,
+		kNumDerivedStates
+	};
+	using Dependencies = ParameterDependencies<kNumGlobalParameters, kNumDerivedStates>;
+
+	// Recompute all derived state that has been invalidated by parameter changes
+	void recomputeDirtyState();
+	virtual void recomputeState(int node, Dependencies::Mask dirtyNodes);
 
-	// Expensive parameter udpates
 	virtual void updateResonatorDimension();
+	virtual void updateResonatorOrder();
 
-	// Update all parameters (expensive and inexpensive)
+	// Resonator dimension and order of a parameter state (the specs depend on the plugin)
+	virtual int dimensionOf(const ParamState& state) const { return resonatorDim; }
+	virtual int orderOf(const ParamState& state) const { return resonatorOrder; }
+	ResonatorSettings resonatorSettings(const ParamState& state) const;
+
+	// Switch to a precomputed preset if the resonator state has been changed to one
+	void recallPreset();
+
+	// Update all parameters
 	void recomputeParameters() override;
 
+	// Create the processor implementation for the current channel configuration
+	virtual std::unique_ptr<ProcessorImplBase> makeProcessorImpl(int32 symbolicSampleSize) const = 0;
+
+	Dependencies dependencies;
+	uint64 processedGeneration{ 0 }; // generation of paramState when its dirty parameters were last processed
 
 
+	// The implementation is kept while the processor is inactive and only recreated when the
+	// channel configuration or the sample size changes.
 	std::unique_ptr<ProcessorImplBase> processorImpl;
+	Configuration configuration{ Configuration::Stereo }; // set by setBusArrangements()
+	Configuration implConfiguration{ Configuration::Stereo };
+	int32 implSampleSize{ kSample32 };
+	SampleRate implSampleRate{ 0 };
+	bool active{ false };
 
 	float volume{ 0 };
 	float mix{ 1 };
@@ -54,7 +94,7 @@ protected:
 	float resonatorFreq{ 0 };
 	float resonatorDamp{ 0 };
 	float resonatorVel{ 0 };
-	bool limiterOn{ false };
+	LimiterMode limiterMode{ LimiterMode::Off };
 
 	double vuPPM = 0; // contains max of left and right channel from last buffer to check if there is silence
 };
@@ -12,8 +12,15 @@
 #pragma once
 
 #include <resonator.h>
-#include <public.sdk/samples/vst/note_expression_synth/source/filter.h>
+#include <simd_math.h>
+#include <biquad.h>
+#include <smoothing.h>
+#include <memory>
+#include <type_traits>
 #include "common_param_specs.h"
+#include "EigenFunctionWorker.h"
+#include "OutputStage.h"
+#include "PresetBank.h"
 
 
 namespace Uberton {
@@ -22,8 +29,19 @@ namespace ResonatorPlugin {
 class ProcessorImplBase
 {
 public:
+	// One-time setup when the implementation is created (starts the background workers)
 	virtual void init(float sampleRate) = 0;
-	virtual float processAll(ProcessData& data, float mix, float volume, bool limit) = 0;
+	// Re-derive the state that depends on the sample rate. The resonator settings, positions and
+	// filter settings are kept.
+	virtual void setSampleRate(float sampleRate) = 0;
+	// Clear the audio state (resonator amplitudes, filter and limiter memory) on re-activation
+	virtual void reset() = 0;
+	// Stop the background workers that only serve process() while the processor is inactive
+	virtual void suspend() = 0;
+	virtual void resume() = 0;
+	virtual float processAll(ProcessData& data, float mix, float volume, LimiterMode limiterMode) = 0;
+	// Latency of the lookahead limiter in samples
+	virtual int32 getLimiterLatency() const = 0;
 	virtual void setResonatorDim(int resonatorDim) = 0;
 	virtual void setResonatorOrder(int resonatorOrder) = 0;
 	virtual void setResonatorFreq(float freq, float damp, float vel) = 0;
@@ -31,39 +49,116 @@ public:
 	virtual void setHCFilterFreqAndQ(double freq, double q) = 0;
 	virtual void updateResonatorInputPosition(const ParamState& paramState) = 0;
 	virtual void updateResonatorOutputPosition(const ParamState& paramState) = 0;
+	// Asynchronous versions of the above: the eigenfunctions are evaluated on a background thread
+	// and the resonator crossfades to them over one block as soon as they are ready.
+	virtual void requestResonatorInputPosition(const ParamState& paramState) = 0;
+	virtual void requestResonatorOutputPosition(const ParamState& paramState) = 0;
+	// Evaluate the modal state (time steps and eigenfunctions) of a preset, right away or on a
+	// background thread (see PresetBank). Not real-time safe.
+	virtual void preparePreset(const ParamState& state, const ResonatorSettings& settings) = 0;
+	virtual void preloadPreset(const ParamState& state, const ResonatorSettings& settings) = 0;
+	// Switch to the precomputed modal state of the parameter state and crossfade the weights.
+	// Returns false if the state is not in the preset bank.
+	virtual bool recallPreset(const ParamState& paramState) = 0;
 	virtual ~ProcessorImplBase() = default;
 };
 
+// Channel layout of the main input and output bus
 enum class Configuration {
-	Mono,
-	Stereo
+	Mono,		  // mono -> mono
+	MonoToStereo, // mono -> stereo
+	Stereo,		  // stereo -> stereo
+	Surround51,	  // stereo -> 5.1
+	Surround71,	  // stereo -> 7.1
+	Surround714	  // stereo -> 7.1.4
 };
 
-template<class Resonator, typename SampleType, int numChannels = 2>
+constexpr int numInputChannels(Configuration configuration) {
+	return configuration == Configuration::Mono || configuration == Configuration::MonoToStereo ? 1 : 2;
+}
+
+constexpr int numOutputChannels(Configuration configuration) {
+	switch (configuration) {
+	case Configuration::Mono: return 1;
+	case Configuration::Surround51: return 6;
+	case Configuration::Surround71: return 8;
+	case Configuration::Surround714: return 12;
+	default: return 2;
+	}
+}
+
+// Number of output positions of the resonator (mono outputs listen to a left and a right position)
+constexpr int numOutputPositions(Configuration configuration) {
+	return std::max(2, numOutputChannels(configuration));
+}
+
+// The resonator always has a left and a right input position and one output position per output
+// channel (at least two). The number of audio channels is fixed at compile time, so each
+// configuration gets its own resonator kernel (see ResonatorBase::processBlock()): a mono input
+// excites both input positions at once, a mono output listens to the mean of both output
+// positions and surround outputs share one modal bank that is projected to all speakers.
+template<class Resonator, typename SampleType, Configuration configuration = Configuration::Stereo>
 class ProcessorImpl : public ProcessorImplBase
 {
 public:
 	using Type = SampleType;
+	static constexpr int numChannels = Resonator::numChannels(); // number of input positions
+	static constexpr int numInputs = numInputChannels(configuration);
+	static constexpr int numOutputs = numOutputChannels(configuration);
+	static constexpr int maxBlockSize = 128;
 
 	using SpaceVec = Math::Vector<SampleType, maxDimension>;
 	using SampleVec = Math::Vector<SampleType, numChannels>;
-	using InputVecArr = std::array<SpaceVec, numChannels>;
 	//using Resonator = Math::PreComputedCubeResonator<SampleType, maxDimension, maxOrder, numChannels>;
-	using Filter = Steinberg::Vst::NoteExpressionSynth::Filter;
+	using Filter = StereoBiquadCascade<SampleType>;
+	using Worker = EigenFunctionWorker<Resonator>;
+	using Positions = typename Worker::Positions;
+	using OutputStage = ResonatorPlugin::OutputStage<SampleType, Filter, maxBlockSize, numOutputs>;
+	using Presets = PresetBank<Resonator>;
 
 
-	static_assert(numChannels == Resonator::numChannels());
-	static_assert(numChannels == Resonator::numChannels());
+	static_assert(numChannels == 2, "the input position parameters are left/right");
+	static_assert(Resonator::numOutputChannels() == numOutputPositions(configuration));
+	static_assert(numOutputs <= maxOutputChannels);
 
 	void init(float sampleRate) override {
-		for (auto& filter : lcFilters) {
-			filter.setSampleRate(sampleRate);
+		setSampleRate(sampleRate);
+
+		curve = spaceCurves();
+		efWorker.setCurve(curve);
+		efWorker.start();
+	}
+
+	void setSampleRate(float sampleRate) override {
+		for (auto& filter : filters) {
+			filter.setSampleRate(sampleRate); // recomputes the coefficients of the current settings
 		}
-		for (auto& filter : hcFilters) {
-			filter.setSampleRate(sampleRate);
+		limiter.setSampleRate(sampleRate);
+		gainSmoothers.setRampTime(gainRampTime, sampleRate);
+		gainsInitialized = false;
+
+		resonator.setSampleRate(sampleRate); // recomputes the time functions, the eigenfunctions stay valid
+
+		presetFadeSamples = static_cast<int>(presetFadeTime * sampleRate);
+		presets.setSampleRate(sampleRate); // the precomputed time functions are for the old rate
+	}
+
+	void reset() override {
+		resonator.clear();
+		for (auto& filter : filters) {
+			filter.reset();
 		}
+		limiter.reset();
+		gainsInitialized = false;
+		vuPPMLSq = vuPPMRSq = 0;
+	}
 
-		resonator.setSampleRate(sampleRate);
+	void suspend() override {
+		efWorker.stop();
+	}
+
+	void resume() override {
+		efWorker.start();
 	}
 
 	void setResonatorDim(int resonatorDim) override {
@@ -93,77 +188,88 @@ public:
 	}
 
 	void setLCFilterFreqAndQ(double freq, double q) override {
-		for (auto& filter : lcFilters) {
-			filter.setFreqAndQ(freq, q);
+		for (auto& filter : filters) {
+			filter.setFreqAndQ(lowCutStage, freq, q);
 		}
 	}
 
 	void setHCFilterFreqAndQ(double freq, double q) override {
-		for (auto& filter : hcFilters) {
-			filter.setFreqAndQ(freq, q);
+		for (auto& filter : filters) {
+			filter.setFreqAndQ(highCutStage, freq, q);
 		}
 	}
 
-	template<typename T>
-	inline T tanh_approx(T x) {
-		T sq = x * x;
-		return x * (27 + sq) / (27 + 9 * sq);
+	int32 getLimiterLatency() const override {
+		return limiter.latencySamples();
 	}
 
 	// returns the max sample of the output buffer
-	float processAll(ProcessData& data, float mix, float volume, bool limit) final {
+	float processAll(ProcessData& data, float mix, float volume, LimiterMode limiterMode) final {
 		int32 numSamples = data.numSamples;
 
 		SampleType** in = (SampleType**)data.inputs[0].channelBuffers32;
 		SampleType** out = (SampleType**)data.outputs[0].channelBuffers32;
 
 
-		float wet = mix;
-		float dry = 1 - wet;
-		std::array<SampleType, numChannels> input;
-		SampleVec tmp;
-		SampleType maxSampleLSq = 0;
-		SampleType maxSampleRSq = 0;
-		// higher resonator orders result in considerably higher volumes
-		//float compensation = 1.f;//		/ std::sqrt(currentResonatorOrder);
-		//compensation = 10;
+		fetchEigenFunctions(numSamples);
 
-		for (int32 i = 0; i < numSamples; i++) {
-			for (int ch = 0; ch < numChannels; ch++) {
-				input[ch] = *(in[ch] + i);
-			}
-			resonator.delta(input);
-			tmp = resonator.next();
-			for (int ch = 0; ch < numChannels; ch++) {
-				tmp[ch] = lcFilters[ch].process(tmp[ch]);
-				tmp[ch] = hcFilters[ch].process(tmp[ch]);
-				tmp[ch] = volume * (tmp[ch] * wet * compensation + dry * (*(in[ch] + i)));
-				if (limit) {
-					tmp[ch] = std::tanh(tmp[ch]);
-					// the tanh approximation is a few times faster but already for higher than the lowest few
-					// resonator orders the actual processing takes much more time than the limiting.
-					// And the approximation is softer / can exceed 1.
-					//tmp[ch] = tanh_approx(tmp[ch]);
-				}
-				*(out[ch] + i) = tmp[ch];
-			}
+		// don't release the gain reduction of a signal that was limited a long time ago
+		if (limiterMode == LimiterMode::Lookahead && currentLimiterMode != LimiterMode::Lookahead) {
+			limiter.reset();
+		}
+		currentLimiterMode = limiterMode;
 
-			maxSampleLSq = std::max(maxSampleLSq, tmp[0] * tmp[0]);
-			if constexpr (numChannels > 1) {
-				maxSampleRSq = std::max(maxSampleRSq, tmp[1] * tmp[1]);
+		// higher resonator orders result in considerably higher volumes
+		const SampleType wetGain = static_cast<SampleType>(volume * mix * compensation);
+		const SampleType dryGain = static_cast<SampleType>(volume * (1 - mix));
+		if (gainsInitialized) {
+			gainSmoothers.set(kWetGain, wetGain);
+			gainSmoothers.set(kDryGain, dryGain);
+		}
+		else {
+			gainSmoothers.reset(kWetGain, wetGain);
+			gainSmoothers.reset(kDryGain, dryGain);
+			gainsInitialized = true;
+		}
+		std::array<typename OutputStage::Levels, numOutputs> levels{};
+
+		// The resonator runs in sub-blocks on a separate buffer because in and out may be the same
+		// (in-place processing) and the dry signal is still needed afterwards.
+		for (int32 blockStart = 0; blockStart < numSamples; blockStart += maxBlockSize) {
+			const int blockSize = std::min<int32>(maxBlockSize, numSamples - blockStart);
+			std::array<const SampleType*, numOutputs> blockIn; // dry signal per output channel
+			std::array<SampleType*, numOutputs> blockWet;
+			std::array<SampleType*, numOutputs> blockOut;
+			for (int ch = 0; ch < numOutputs; ch++) {
+				blockIn[ch] = drySignal(in, ch, blockStart);
+				blockWet[ch] = wetBuffer[ch].data();
+				blockOut[ch] = out[ch] + blockStart;
 			}
+			resonator.template processBlock<numInputs, numOutputs>(blockIn.data(), blockWet.data(), blockSize);
+
+			// volume and mix changes are ramped per sample instead of jumping at the block boundaries
+			gainSmoothers.process(blockSize);
+			const typename OutputStage::Gains gains{ gainSmoothers.get(kWetGain), gainSmoothers.get(kDryGain), gainSmoothers.ramp(kWetGain), gainSmoothers.ramp(kDryGain) };
+
+			OutputStage::process(blockWet.data(), blockIn.data(), blockOut.data(), numOutputs, blockSize, filters.data(), gains, limiterMode, limiter, levels.data());
 		}
+
+		// the levels replace ProcessorBase::checkSilence()
+		uint64 silenceFlags = 0;
+		for (int ch = 0; ch < numOutputs; ch++) {
+			if (levels[ch].isSilent()) silenceFlags |= uint64{ 1 } << ch;
+		}
+		data.outputs[0].silenceFlags = silenceFlags;
+
+		const SampleType maxSampleLSq = levels[0].peakSq;
+		const SampleType maxSampleRSq = levels[std::min(1, numOutputs - 1)].peakSq; // mono: both meters show the same level
 		if (vuPPMLSq != maxSampleLSq || vuPPMRSq != maxSampleRSq) {
 			addOutputPoint(data, kParamVUPPM_L, std::sqrt(maxSampleLSq) * vuPPMNormalizedMultiplicatorInv);
 			addOutputPoint(data, kParamVUPPM_R, std::sqrt(maxSampleRSq) * vuPPMNormalizedMultiplicatorInv);
 			vuPPMLSq = maxSampleLSq;
 			vuPPMRSq = maxSampleRSq;
 		}
-		if constexpr (numChannels == 1) {
-			return maxSampleLSq;
-		} else {
-			return std::max(maxSampleLSq, maxSampleRSq);
-		}
+		return std::max(maxSampleLSq, maxSampleRSq);
 	}
     
     static void addOutputPoint(ProcessData& data, ParamID id, ParamValue value) {
@@ -177,38 +283,176 @@ public:
         }
 
 	void updateResonatorInputPosition(const ParamState& paramState) override {
-		InputVecArr inputPositions;
-		int d = static_cast<int>(inputPositions[0].size());
-		for (int i = 0; i < d; i++) {
-			inputPositions[0][i] = paramState[Params::kParamOutL0 + i];
-			if constexpr (numChannels > 1)
-				inputPositions[1][i] = paramState[Params::kParamOutR0 + i];
-		}
-		inputPositions[0] += inputPosSpaceCurve(paramState[Params::kParamInPosCurveL]);
-		if constexpr (numChannels > 1)
-			inputPositions[1] += inputPosSpaceCurve(paramState[Params::kParamInPosCurveR]);
-		resonator.setInputPositions(inputPositions);
+		updatePosition(Worker::InputPositions, paramState);
 	}
 
 	void updateResonatorOutputPosition(const ParamState& paramState) override {
-		InputVecArr outputPositions;
-		int d = static_cast<int>(outputPositions[0].size());
-		for (int i = 0; i < d; i++) {
-			outputPositions[0][i] = paramState[Params::kParamOutL0 + i];
-			if constexpr (numChannels > 1)
-				outputPositions[1][i] = paramState[Params::kParamOutR0 + i];
+		updatePosition(Worker::OutputPositions, paramState);
+	}
+
+	void requestResonatorInputPosition(const ParamState& paramState) override {
+		requestPosition(Worker::InputPositions, paramState);
+	}
+
+	void requestResonatorOutputPosition(const ParamState& paramState) override {
+		requestPosition(Worker::OutputPositions, paramState);
+	}
+
+	void preparePreset(const ParamState& state, const ResonatorSettings& settings) override {
+		presets.prepare(state, settings, computePositions(Worker::InputPositions, state), computePositions(Worker::OutputPositions, state));
+	}
+
+	void preloadPreset(const ParamState& state, const ResonatorSettings& settings) override {
+		presets.preload(state, settings, computePositions(Worker::InputPositions, state), computePositions(Worker::OutputPositions, state));
+	}
+
+	bool recallPreset(const ParamState& paramState) override {
+		const auto* modes = presets.acquire(paramState);
+		if (!modes) return false;
+		const ResonatorSettings& settings = modes->settings;
+		resonator.setDim(settings.dim);
+		setResonatorOrder(settings.order);
+		resonator.setFreqDampeningAndVelocity(settings.freq, settings.damp, settings.vel, modes->timeFunctions);
+		currentResFreq = settings.freq;
+		currentResDamp = settings.damp;
+		currentResVel = settings.vel;
+		resonator.fadeInputPositionEF(modes->inputEF, presetFadeSamples);
+		resonator.fadeOutputPositionEF(modes->outputEF, presetFadeSamples);
+		presets.release();
+
+		// drop position updates that are still pending for the previous state
+		for (int j = 0; j < Worker::numJobs; j++) {
+			const Job job = static_cast<Job>(j);
+			appliedGeneration[job] = ++requestedGeneration[job];
+			curveTarget[job].pending = false;
+			updateCurveTable(job, paramState);
 		}
-		outputPositions[0] += outputPosSpaceCurve(paramState[Params::kParamOutPosCurveL]);
-		if constexpr (numChannels > 1)
-			outputPositions[1] += outputPosSpaceCurve(paramState[Params::kParamOutPosCurveR]);
-		resonator.setOutputPositions(outputPositions);
+		return true;
 	}
 
 
 
 protected:
+	using Job = typename Worker::Job;
+	using Curve = typename Worker::Curve;
+
+	// The mono input is mixed to both outputs. In surround configurations only L and R carry the
+	// dry signal.
+	const SampleType* drySignal(SampleType* const* in, int ch, int blockStart) const {
+		if constexpr (numOutputs <= 2)
+			return in[std::min(ch, numInputs - 1)] + blockStart;
+		else
+			return ch < numInputs ? in[ch] + blockStart : silence.data();
+	}
+
+	// The space curves map the curve parameters to an offset of the base positions. They are
+	// also evaluated on the worker thread, so they need to be free of side effects.
+	virtual Curve spaceCurves() const {
+		return [](Job job, double t) {
+			return job == Worker::InputPositions ? inputPosSpaceCurve(t) : outputPosSpaceCurve(t);
+		};
+	}
+
+	// Positions set by the position parameters (without space curve offset). The input positions
+	// use the left/right output position parameters as well.
+	Positions basePositions(Job job, const ParamState& paramState) const {
+		Positions positions{};
+		int d = static_cast<int>(positions[0].size());
+		for (int ch = 0; ch < Worker::numPositions(job); ch++) {
+			for (int i = 0; i < d; i++) {
+				positions[ch][i] = paramState[outputPositionParam(ch, i)];
+			}
+		}
+		return positions;
+	}
+
+	// The surround layouts are ordered in left/right pairs (L R C Lfe Ls Rs ...), so even channels
+	// follow the left and odd channels the right curve.
+	std::array<double, Worker::channels> curveParameters(Job job, const ParamState& paramState) const {
+		const double tL = paramState[job == Worker::InputPositions ? Params::kParamInPosCurveL : Params::kParamOutPosCurveL];
+		const double tR = paramState[job == Worker::InputPositions ? Params::kParamInPosCurveR : Params::kParamOutPosCurveR];
+		std::array<double, Worker::channels> t{};
+		for (int ch = 0; ch < Worker::numPositions(job); ch++) {
+			t[ch] = ch % 2 == 0 ? tL : tR;
+		}
+		return t;
+	}
+
+	Positions computePositions(Job job, const ParamState& paramState) const {
+		Positions positions = basePositions(job, paramState);
+		const auto t = curveParameters(job, paramState);
+		for (int ch = 0; ch < Worker::numPositions(job); ch++) {
+			positions[ch] += curve(job, t[ch]);
+		}
+		return positions;
+	}
+
+	void updatePosition(Job job, const ParamState& paramState) {
+		if (job == Worker::InputPositions)
+			resonator.setInputPositions(computePositions(job, paramState));
+		else
+			resonator.setOutputPositions(computePositions(job, paramState));
+		appliedGeneration[job] = ++requestedGeneration[job];
+		curveTarget[job].pending = false;
+		updateCurveTable(job, paramState);
+	}
+
+	// If only the curve parameter changed and the curve table for the current base positions is
+	// ready, the new weights are interpolated from the table right away. Otherwise the worker
+	// evaluates them.
+	void requestPosition(Job job, const ParamState& paramState) {
+		updateCurveTable(job, paramState);
+		if (curveTables[job]) {
+			curveTables[job]->interpolate(curveParameters(job, paramState), curveTarget[job].ef);
+			curveTarget[job].pending = true;
+			appliedGeneration[job] = ++requestedGeneration[job];
+		} else {
+			efWorker.request(job, computePositions(job, paramState), resonator.getDim(), ++requestedGeneration[job]);
+		}
+	}
+
+	// Request a new curve table when the base positions or the dimension changed
+	void updateCurveTable(Job job, const ParamState& paramState) {
+		const Positions base = basePositions(job, paramState);
+		const int dim = resonator.getDim();
+		if (tableDim[job] == dim && tableBase[job] == base) return;
+		tableBase[job] = base;
+		tableDim[job] = dim;
+		curveTables[job] = nullptr;
+		efWorker.requestCurveTable(job, base, dim, ++tableGeneration[job]);
+	}
+
+	// Pick up curve tables and eigenfunctions the worker has finished and crossfade to new weights
+	// over this block. Results that are older than the last applied update or that were computed
+	// for another dimension are dropped.
+	void fetchEigenFunctions(int numSamples) {
+		for (int j = 0; j < Worker::numJobs; j++) {
+			const Job job = static_cast<Job>(j);
+			if (const auto* table = efWorker.fetchCurveTable(job)) {
+				curveTables[job] = (table->generation == tableGeneration[job]) ? table : nullptr;
+			}
+
+			const typename Worker::EFArray* ef = nullptr;
+			if (curveTarget[job].pending) {
+				curveTarget[job].pending = false;
+				ef = &curveTarget[job].ef;
+			}
+			if (const auto* result = efWorker.fetch(job)) {
+				if (result->generation > appliedGeneration[job] && result->dim == resonator.getDim()) {
+					appliedGeneration[job] = result->generation;
+					ef = &result->ef;
+				}
+			}
+			if (!ef) continue;
+			if (job == Worker::InputPositions)
+				resonator.fadeInputPositionEF(*ef, numSamples);
+			else
+				resonator.fadeOutputPositionEF(*ef, numSamples);
+		}
+	}
+
 	// t in [0,1]; returns 0 vector for t = 0.5
-	SpaceVec inputPosSpaceCurve(ParamValue t) const {
+	static SpaceVec inputPosSpaceCurve(ParamValue t) {
 		constexpr SampleType pi = Math::pi<SampleType>();
 		const SampleType t_ = t - .5;
 		const SampleType phi = t_ * 1.5 * pi;
@@ -230,23 +474,80 @@ protected:
 	}
 
 	// t in [0,1]; returns 0 vector for t = 0.5
-	SpaceVec outputPosSpaceCurve(ParamValue t) const {
+	static SpaceVec outputPosSpaceCurve(ParamValue t) {
 		return inputPosSpaceCurve(t);
 	}
 
 
 	Resonator resonator;
-	std::array<Filter, numChannels> lcFilters{ Filter::Type::kHighpass, Filter::Type::kHighpass };
-	std::array<Filter, numChannels> hcFilters{ Filter::Type::kLowpass, Filter::Type::kLowpass };
+	static constexpr int lowCutStage = 0;
+	static constexpr int highCutStage = 1;
+	// one stereo filter per channel pair
+	std::array<Filter, (numOutputs + 1) / 2> filters{};
 
 	SampleType currentResFreq = 1, currentResDamp = 1, currentResVel = 1;
 	int currentResonatorOrder = 1;
 	float compensation = 0.03f / std::sqrt(currentResonatorOrder);
 
+	std::array<std::array<SampleType, maxBlockSize>, numOutputs> wetBuffer{};
+	std::array<SampleType, maxBlockSize> silence{}; // dry signal of surround channels
+	typename OutputStage::Limiter limiter;
+	LimiterMode currentLimiterMode{ LimiterMode::Off };
+
+	enum SmoothedGains {
+		kWetGain,
+		kDryGain,
+		kNumSmoothedGains
+	};
+	static constexpr double gainRampTime = 0.02; // seconds
+	ParameterSmoothers<SampleType, kNumSmoothedGains, maxBlockSize> gainSmoothers;
+	bool gainsInitialized{ false }; // the first block starts at the current gains
+
+	Worker efWorker;
+	Curve curve;
+	std::array<uint64_t, Worker::numJobs> requestedGeneration{};
+	std::array<uint64_t, Worker::numJobs> appliedGeneration{};
+
+	// curve tables for the current base positions (nullptr while they are being built)
+	std::array<const typename Worker::CurveTable*, Worker::numJobs> curveTables{};
+	std::array<Positions, Worker::numJobs> tableBase{};
+	std::array<int, Worker::numJobs> tableDim{};
+	std::array<uint64_t, Worker::numJobs> tableGeneration{};
+
+	struct CurveTarget
+	{
+		typename Worker::EFArray ef{};
+		bool pending{ false };
+	};
+	std::array<CurveTarget, Worker::numJobs> curveTarget{};
+
+	Presets presets;
+	static constexpr double presetFadeTime = 0.01; // seconds
+	int presetFadeSamples{ 1 };
+
 	//SampleVec output
 	SampleType vuPPMLSq{ 0 };
 	SampleType vuPPMRSq{ 0 };
 };
 
+// Create the processor implementation for the channel configuration of the busses. Resonator<T, n>
+// is the resonator type with sample type T and n output positions.
+template<template<class, class, Configuration> class Impl, template<class, int> class Resonator, class SampleType>
+std::unique_ptr<ProcessorImplBase> createProcessorImpl(Configuration configuration) {
+	auto create = [](auto c) -> std::unique_ptr<ProcessorImplBase> {
+		constexpr Configuration config = decltype(c)::value;
+		return std::make_unique<Impl<Resonator<SampleType, numOutputPositions(config)>, SampleType, config>>();
+	};
+	switch (configuration) {
+	case Configuration::Mono: return create(std::integral_constant<Configuration, Configuration::Mono>{});
+	case Configuration::MonoToStereo: return create(std::integral_constant<Configuration, Configuration::MonoToStereo>{});
+	case Configuration::Stereo: break;
+	case Configuration::Surround51: return create(std::integral_constant<Configuration, Configuration::Surround51>{});
+	case Configuration::Surround71: return create(std::integral_constant<Configuration, Configuration::Surround71>{});
+	case Configuration::Surround714: return create(std::integral_constant<Configuration, Configuration::Surround714>{});
+	}
+	return create(std::integral_constant<Configuration, Configuration::Stereo>{});
+}
+
 }
 }
@@ -23,6 +23,7 @@ namespace Uberton {
 namespace ResonatorPlugin {
 
 constexpr int maxDimension = 10;
+constexpr int maxOutputChannels = 12; // 7.1.4
 
 constexpr double vuPPMOverheadDB = 2;
 const double vuPPMNormalizedMultiplicator = std::pow(10, vuPPMOverheadDB / 20.0);
@@ -66,9 +67,21 @@ enum Params : Steinberg::Vst::ParamID {
 	kParamResonatorLength, // OUT
 
 	kParamLimiterOn,
+	kParamLimiterMode,
+
+	// output positions of the surround channels after L and R
+	kParamOutSurround0,
+	kParamOutSurroundN = kParamOutSurround0 + (maxOutputChannels - 2) * maxDimension - 1,
 	kNumGlobalParameters
 };
 
+// Parameter of coordinate i of the output position for the given output channel
+constexpr Steinberg::Vst::ParamID outputPositionParam(int channel, int i) {
+	if (channel == 0) return kParamOutL0 + i;
+	if (channel == 1) return kParamOutR0 + i;
+	return kParamOutSurround0 + (channel - 2) * maxDimension + i;
+}
+
 
 namespace ParamSpecs {
 
@@ -102,11 +115,15 @@ static const LinearParamSpec vuPPMR{ kParamVUPPM_R, 0.0, 1.0, 0.0, 0.0 };
 static const LinearParamSpec processTime{ kParamProcessTime, 0, 10, 0.0, 0.0 };
 
 static const ParamSpec limiterOn{ kParamLimiterOn, 0, 1, 1, 1 };
+static const ParamSpec limiterMode{ kParamLimiterMode, 0, 1, 0, 0 }; // 0: soft clip, 1: lookahead
 }
 
 using ParamState = UniformParamState<kNumGlobalParameters>;
 
 static const Steinberg::FIDString processorDeactivatedMsgID = "pDeactivated";
+// sent on activation, int attribute numOutputChannelsAttr with the channel count of the output bus
+static const Steinberg::FIDString outputChannelsMsgID = "pOutputChannels";
+static const char* const numOutputChannelsAttr = "channels";
 
 }
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+// Test of the block rendering of the ADSR envelopes (see adsr.h)
+//  - render() must produce the same values as calling next() per sample, for any block size
+//  - covers all periods, a release during the attack and parameter changes during a period
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <adsr.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+
+constexpr double tolerance = 1e-6;
+
+// Something that happens to the envelope before the sample at the given index
+template<class Envelope>
+struct Event
+{
+	int index;
+	std::function<void(Envelope&)> apply;
+};
+
+// Largest difference between render() in blocks of blockSize and next() per sample
+template<class Envelope>
+double maxDifference(Envelope envelope, const std::vector<Event<Envelope>>& events, int numSamples, int blockSize) {
+	Envelope reference = envelope;
+	std::vector<float> block(blockSize);
+	double error = 0;
+	size_t nextEvent = 0;
+	for (int start = 0; start < numSamples;) {
+		while (nextEvent < events.size() && events[nextEvent].index == start) {
+			events[nextEvent].apply(envelope);
+			events[nextEvent].apply(reference);
+			nextEvent++;
+		}
+		// blocks end at the events, like the processors split their blocks at the note events
+		int end = std::min(start + blockSize, numSamples);
+		if (nextEvent < events.size()) end = std::min(end, events[nextEvent].index);
+		envelope.render(block.data(), end - start);
+		for (int i = 0; i < end - start; i++) {
+			error = std::max(error, std::abs(block[i] - reference.next()));
+		}
+		start = end;
+	}
+	return error;
+}
+
+int numFailures = 0;
+
+template<class Envelope>
+void check(const char* name, Envelope envelope, const std::vector<Event<Envelope>>& events, int numSamples) {
+	for (int blockSize : { 1, 7, 64 }) {
+		const double error = maxDifference(envelope, events, numSamples, blockSize);
+		const bool ok = error <= tolerance;
+		std::printf("%-48s block size %2d %10.3g%s\n", name, blockSize, error, ok ? "" : "  FAILED");
+		if (!ok) numFailures++;
+	}
+}
+
+void testQuadratic() {
+	using Envelope = QuadraticADSREnvelope;
+	Envelope envelope;
+	envelope.setParams(100, 250, 0.4, 300);
+	const auto start = [](Envelope& e) { e.start(); };
+	const auto release = [](Envelope& e) { e.release(); };
+
+	check<Envelope>("quadratic: attack, decay, sustain, release", envelope, { { 0, start }, { 500, release } }, 1000);
+	check<Envelope>("quadratic: release during the attack", envelope, { { 0, start }, { 37, release } }, 500);
+	check<Envelope>("quadratic: release during the decay", envelope, { { 0, start }, { 163, release } }, 600);
+	check<Envelope>("quadratic: restart during the release", envelope, { { 0, start }, { 400, release }, { 555, start }, { 900, release } }, 1400);
+}
+
+void testLinear() {
+	using Envelope = LinearADSREnvelope;
+	Envelope envelope;
+	envelope.set(100, 250, 0.4, 300);
+	const auto start = [](Envelope& e) { e.start(); };
+	const auto release = [](Envelope& e) { e.release(); };
+	const auto change = [](Envelope& e) { e.set(60, 120, 0.6, 80); };
+
+	check<Envelope>("linear: attack, decay, sustain, release", envelope, { { 0, start }, { 500, release } }, 1000);
+	check<Envelope>("linear: release during the attack", envelope, { { 0, start }, { 37, release } }, 500);
+	check<Envelope>("linear: change during the attack", envelope, { { 0, start }, { 41, change }, { 400, release } }, 700);
+	check<Envelope>("linear: change during the decay", envelope, { { 0, start }, { 130, change }, { 400, release } }, 700);
+	check<Envelope>("linear: change during the release", envelope, { { 0, start }, { 400, release }, { 450, change } }, 900);
+}
+
+} // namespace
+
+
+int main() {
+	testQuadratic();
+	testLinear();
+	return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+// Test of the block oscillators (see oscillators.h)
+//  - sine and sin⁵ against the per-sample oscillators
+//  - PolyBLEP rect and PolyBLAMP triangle against the naive per-sample oscillators, the
+//    corrections may only differ next to the discontinuities
+//  - wrapping of the fixed point phase and the sum of an oscillator bank
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <oscillators.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace Uberton;
+
+namespace {
+
+constexpr double sampleRate = 48000;
+constexpr int numSamples = 4099; // a few cycles, not a multiple of the block or vector size
+
+int numFailures = 0;
+
+void check(const char* name, bool ok) {
+	std::printf("%-60s %s\n", name, ok ? "ok" : "FAILED");
+	if (!ok) numFailures++;
+}
+
+template<Waveform waveform>
+std::vector<float> renderBlock(double frequency, int n) {
+	BlockOscillator<waveform> osc;
+	osc.setSampleRate(sampleRate);
+	osc.setFrequency(frequency);
+	std::vector<float> out(n);
+	// uneven chunks, the phase continues across render() calls
+	for (int start = 0, chunk = 1; start < n; start += chunk, chunk = chunk * 3 % 97 + 1) {
+		osc.render(out.data() + start, std::min(chunk, n - start));
+	}
+	return out;
+}
+
+std::vector<double> renderSamples(Oscillator& osc, double frequency, int n) {
+	osc.setSampleRate(sampleRate);
+	osc.setFrequency(frequency);
+	std::vector<double> out(n);
+	for (double& y : out) y = osc.get();
+	return out;
+}
+
+// Largest difference, skipping the samples whose phase u (in cycles) is closer than dt to one of
+// the given discontinuities
+double maxDifference(const std::vector<float>& a, const std::vector<double>& b, double dt, std::vector<double> discontinuities = {}) {
+	double error = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		const double u = std::fmod(i * dt, 1.0);
+		bool skip = false;
+		for (double d : discontinuities) {
+			const double distance = std::abs(u - d);
+			skip |= std::min(distance, 1 - distance) < dt;
+		}
+		if (!skip) error = std::max(error, std::abs(a[i] - b[i]));
+	}
+	return error;
+}
+
+void testShapes() {
+	// 750 Hz is 1/64 of the sample rate, so the fixed point phase increment is exact
+	const double frequency = sampleRate / 64;
+	const double dt = frequency / sampleRate;
+
+	SineOscillator sine;
+	check("sine matches SineOscillator", maxDifference(renderBlock<Waveform::Sine>(frequency, numSamples), renderSamples(sine, frequency, numSamples), dt) < 2e-6);
+
+	SineOscillatorPow5 sinePow5;
+	check("sin^5 matches SineOscillatorPow5", maxDifference(renderBlock<Waveform::SinePow5>(frequency, numSamples), renderSamples(sinePow5, frequency, numSamples), dt) < 2e-6);
+
+	// the corrections only act within one sample of the edges at u = 0 and u = ½
+	RectOscillator rect;
+	const auto blockRect = renderBlock<Waveform::Rect>(frequency, numSamples);
+	check("rect matches RectOscillator away from the edges", maxDifference(blockRect, renderSamples(rect, frequency, numSamples), dt, { 0, 0.5 }) == 0);
+	TriangleOscillator triangle;
+	const auto blockTriangle = renderBlock<Waveform::Triangle>(frequency, numSamples);
+	check("triangle matches TriangleOscillator away from the corners", maxDifference(blockTriangle, renderSamples(triangle, frequency, numSamples), dt, { 0, 0.5 }) < 1e-6);
+
+	// at a frequency that does not divide the sample rate, the edges fall between the samples
+	const double detuned = 1234.5;
+	bool bounded = true;
+	double mean = 0;
+	for (float y : renderBlock<Waveform::Rect>(detuned, 48000)) {
+		bounded &= std::abs(y) <= 1.f;
+		mean += y / 48000.;
+	}
+	check("rect is bounded and has no DC offset", bounded && std::abs(mean) < 1e-3);
+	bounded = true;
+	for (float y : renderBlock<Waveform::Triangle>(detuned, 48000)) {
+		bounded &= std::abs(y) <= 1.f;
+	}
+	check("triangle is bounded", bounded);
+
+	// the PolyBLEP corrections remove most of the aliasing: the naive rect steps by 2 between
+	// neighbouring samples at the edges, the corrected one in two smaller steps
+	float maxStep = 0;
+	const auto detunedRect = renderBlock<Waveform::Rect>(detuned, 48000);
+	for (size_t i = 1; i < detunedRect.size(); i++) {
+		maxStep = std::max(maxStep, std::abs(detunedRect[i] - detunedRect[i - 1]));
+	}
+	check("rect edges are spread over two samples", maxStep < 2.f);
+}
+
+void testPhase() {
+	PhaseAccumulator phase;
+	phase.setPhase(1.25);
+	float u;
+	phase.render(&u, 1);
+	check("setPhase() wraps to [0, 1)", u == 0.25f);
+
+	// the accumulator wraps after 2³² / increment samples, the phase stays exact over any run time
+	const double frequency = 1000.5;
+	phase.setPhase(0);
+	phase.setIncrement(frequency, sampleRate);
+	const uint32_t increment = static_cast<uint32_t>(std::llround(frequency / sampleRate * 4294967296.0));
+	std::vector<float> block(4096);
+	bool inRange = true;
+	uint64_t n = 0;
+	for (; n < (uint64_t{ 1 } << 26); n += block.size()) {
+		phase.render(block.data(), static_cast<int>(block.size()));
+		for (float p : block) inRange &= p >= 0.f && p < 1.f;
+	}
+	phase.render(&u, 1);
+	const uint32_t expected = static_cast<uint32_t>(n * increment); // modulo 2³²
+	check("phase stays in [0, 1)", inRange);
+	check("phase after 2^26 samples is exact", u == static_cast<float>(expected >> 8) / 16777216.f);
+
+	// setIncrement() keeps the increment below Nyquist
+	phase.setIncrement(sampleRate, sampleRate);
+	check("increment is limited below 0.5", phase.getIncrement() < 0.5f);
+}
+
+void testBank() {
+	constexpr int numOscillators = 3;
+	const double frequencies[numOscillators] = { 110, 220.5, 1234 };
+	const float gains[numOscillators] = { 0.5f, 0.f, -0.25f };
+
+	OscillatorBank<Waveform::Triangle, numOscillators> bank;
+	std::array<BlockOscillator<Waveform::Triangle>, numOscillators> single;
+	bank.setSampleRate(sampleRate);
+	for (int k = 0; k < numOscillators; k++) {
+		bank.setFrequency(k, frequencies[k]);
+		bank.setGain(k, gains[k]);
+		single[k].setSampleRate(sampleRate);
+		single[k].setFrequency(frequencies[k]);
+	}
+	std::vector<float> sum(numSamples, 1.f), expected(numSamples, 1.f);
+	bank.render(sum.data(), numSamples);
+	for (int k = 0; k < numOscillators; k++) {
+		if (gains[k] != 0) single[k].renderAdd(expected.data(), numSamples, gains[k]);
+	}
+	check("bank adds the enabled oscillators", sum == expected);
+}
+
+} // namespace
+
+
+int main() {
+	testShapes();
+	testPhase();
+	testBank();
+	return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+// Real-time safety test of a plugin (see rt_audit.h)
+//  - built with UBERTON_RT_AUDIT for every plugin, linked with the sources of the plugin
+//  - sweeps all parameters of each processor over process() blocks, fails on any violation
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <rt_audit.h>
+#include <pluginterfaces/base/ipluginbase.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <pluginterfaces/vst/ivstevents.h>
+#include <public.sdk/source/common/memorystream.h>
+#include <public.sdk/source/vst/hosting/eventlist.h>
+#include <public.sdk/source/vst/hosting/hostclasses.h>
+#include <public.sdk/source/vst/hosting/parameterchanges.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr double sampleRate = 48000;
+constexpr int32 blockSize = 256;
+constexpr int numBlocks = 3000;
+constexpr int parameterStride = 8; // each parameter changes in every 8th block
+constexpr int noteStride = 12;
+constexpr int stateStride = 500; // setState() with the current state (transferred to process())
+
+template<class T>
+IPtr<T> createInstance(IPluginFactory* factory, const TUID cid) {
+	T* object = nullptr;
+	if (factory->createInstance(cid, T::iid, reinterpret_cast<void**>(&object)) != kResultOk) return nullptr;
+	return owned(object);
+}
+
+// Audio buffers for all busses of one direction
+struct Busses
+{
+	std::vector<std::vector<std::vector<Sample32>>> channels;
+	std::vector<std::vector<Sample32*>> pointers;
+	std::vector<AudioBusBuffers> buffers;
+
+	void setup(IComponent* component, BusDirection direction) {
+		const int32 numBusses = component->getBusCount(kAudio, direction);
+		channels.resize(numBusses);
+		pointers.resize(numBusses);
+		buffers.resize(numBusses);
+		for (int32 bus = 0; bus < numBusses; bus++) {
+			BusInfo info{};
+			component->getBusInfo(kAudio, direction, bus, info);
+			component->activateBus(kAudio, direction, bus, true);
+			channels[bus].assign(info.channelCount, std::vector<Sample32>(blockSize, 0.f));
+			for (auto& channel : channels[bus]) {
+				pointers[bus].push_back(channel.data());
+			}
+			buffers[bus].numChannels = info.channelCount;
+			buffers[bus].silenceFlags = 0;
+			buffers[bus].channelBuffers32 = pointers[bus].data();
+		}
+	}
+
+	void fill(int block) {
+		for (auto& bus : channels) {
+			for (auto& channel : bus) {
+				for (int32 i = 0; i < blockSize; i++) {
+					channel[i] = 0.5f * std::sin(0.05f * static_cast<float>(block * blockSize + i));
+				}
+			}
+		}
+	}
+};
+
+// Writable parameters of the controller that belongs to the component
+std::vector<ParamID> parameterIds(IPluginFactory* factory, IComponent* component, FUnknown* hostContext) {
+	std::vector<ParamID> ids;
+	TUID controllerCid;
+	if (component->getControllerClassId(controllerCid) != kResultOk) return ids;
+	IPtr<IEditController> controller = createInstance<IEditController>(factory, controllerCid);
+	if (!controller || controller->initialize(hostContext) != kResultOk) return ids;
+	for (int32 i = 0; i < controller->getParameterCount(); i++) {
+		ParameterInfo info{};
+		controller->getParameterInfo(i, info);
+		if ((info.flags & ParameterInfo::kIsReadOnly) == 0) ids.push_back(info.id);
+	}
+	controller->terminate();
+	return ids;
+}
+
+// Returns the number of violations in the processor
+unsigned long auditProcessor(IPluginFactory* factory, const PClassInfo& classInfo, FUnknown* hostContext) {
+	IPtr<IComponent> component = createInstance<IComponent>(factory, classInfo.cid);
+	if (!component || component->initialize(hostContext) != kResultOk) {
+		std::fprintf(stderr, "%s: could not create the component\n", classInfo.name);
+		return 1;
+	}
+	FUnknownPtr<IAudioProcessor> processor(component);
+	if (!processor) return 1;
+	const std::vector<ParamID> ids = parameterIds(factory, component, hostContext);
+
+	Busses inputs, outputs;
+	inputs.setup(component, kInput);
+	outputs.setup(component, kOutput);
+	const bool hasEventInput = component->getBusCount(kEvent, kInput) > 0;
+	if (hasEventInput) component->activateBus(kEvent, kInput, 0, true);
+
+	ProcessSetup setup{ kRealtime, kSample32, blockSize, sampleRate };
+	processor->setupProcessing(setup);
+	component->setActive(true);
+	processor->setProcessing(true);
+
+	// everything process() may touch is allocated up front, it needs to stay within the capacity
+	const int32 numIds = static_cast<int32>(ids.size());
+	ParameterChanges inputChanges(numIds);
+	ParameterChanges outputChanges(numIds + 8);
+	EventList events(16);
+	ProcessContext context{};
+	context.sampleRate = sampleRate;
+	context.tempo = 120;
+	context.state = ProcessContext::kPlaying | ProcessContext::kTempoValid;
+	MemoryStream state;
+
+	ProcessData data;
+	data.processMode = kRealtime;
+	data.symbolicSampleSize = kSample32;
+	data.numSamples = blockSize;
+	data.numInputs = static_cast<int32>(inputs.buffers.size());
+	data.numOutputs = static_cast<int32>(outputs.buffers.size());
+	data.inputs = inputs.buffers.data();
+	data.outputs = outputs.buffers.data();
+	data.inputParameterChanges = &inputChanges;
+	data.outputParameterChanges = &outputChanges;
+	data.inputEvents = hasEventInput ? &events : nullptr;
+	data.processContext = &context;
+
+	const unsigned long violationsBefore = Uberton::RTAudit::numViolations();
+	for (int block = 0; block < numBlocks; block++) {
+		inputChanges.clearQueue();
+		outputChanges.clearQueue();
+		events.clear();
+		inputs.fill(block);
+
+		for (int32 k = 0; k < numIds; k++) {
+			if ((block + k) % parameterStride != 0) continue;
+			// slow sweep with a different phase per parameter
+			const double phase = 0.002 * block + 0.618 * k;
+			const ParamValue value = 0.5 - 0.5 * std::cos(6.283185307179586 * phase);
+			int32 index;
+			if (IParamValueQueue* queue = inputChanges.addParameterData(ids[k], index)) {
+				queue->addPoint(k % blockSize, value, index);
+			}
+		}
+
+		if (hasEventInput && block % noteStride == 0) {
+			Event event{};
+			event.type = Event::kNoteOnEvent;
+			event.sampleOffset = block % blockSize;
+			event.noteOn.channel = 0;
+			event.noteOn.pitch = static_cast<int16>(24 + block / noteStride % 72);
+			event.noteOn.velocity = 0.8f;
+			event.noteOn.noteId = -1;
+			events.addEvent(event);
+			if (block >= 4 * noteStride) {
+				event.type = Event::kNoteOffEvent;
+				event.noteOff.channel = 0;
+				event.noteOff.pitch = static_cast<int16>(24 + (block / noteStride - 4) % 72);
+				event.noteOff.velocity = 0;
+				event.noteOff.noteId = -1;
+				events.addEvent(event);
+			}
+		}
+
+		if (block % stateStride == stateStride - 1) {
+			state.setSize(0);
+			state.seek(0, IBStream::kIBSeekSet, nullptr);
+			component->getState(&state);
+			state.seek(0, IBStream::kIBSeekSet, nullptr);
+			component->setState(&state);
+		}
+
+		context.projectTimeSamples = static_cast<TSamples>(block) * blockSize;
+		processor->process(data);
+	}
+	const unsigned long violations = Uberton::RTAudit::numViolations() - violationsBefore;
+
+	processor->setProcessing(false);
+	component->setActive(false);
+	component->terminate();
+
+	std::printf("%s: %d blocks, %d parameters, %lu real-time violations\n", classInfo.name, numBlocks, numIds, violations);
+	return violations;
+}
+
+} // namespace
+
+
+int main() {
+	IPluginFactory* factory = GetPluginFactory();
+	if (!factory) return 1;
+	IPtr<HostApplication> host = owned(new HostApplication());
+
+	unsigned long violations = 0;
+	for (int32 i = 0; i < factory->countClasses(); i++) {
+		PClassInfo classInfo;
+		if (factory->getClassInfo(i, &classInfo) != kResultOk) continue;
+		if (std::strcmp(classInfo.category, kVstAudioEffectClass) != 0) continue;
+		violations += auditProcessor(factory, classInfo, host);
+	}
+	factory->release();
+
+	// the stack traces are in the report (UBERTON_RT_AUDIT_REPORT or stderr)
+	return violations > 0 ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+// Timing of the plugin scan path of built modules (see scan_timer.h)
+//  - loads each module through the VST3 factory like a host scanning it
+//  - runs create, initialize(), getState()/setState() and terminate() N times per class
+//
+// Usage:
+//   uberton_scan_benchmark [-n N] Tesseract.vst3 Hypersphere.vst3 ...
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivsteditcontroller.h>
+#include <public.sdk/source/common/memorystream.h>
+#include <public.sdk/source/vst/hosting/hostclasses.h>
+#include <public.sdk/source/vst/hosting/module.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void rewind(MemoryStream& stream) {
+	stream.seek(0, IBStream::kIBSeekSet, nullptr);
+}
+
+// One host scan of a processor class and its controller, returns false on failure
+bool scan(const VST3::Hosting::PluginFactory& factory, const VST3::Hosting::ClassInfo& classInfo, FUnknown* hostContext) {
+	IPtr<IComponent> component = factory.createInstance<IComponent>(classInfo.ID());
+	if (!component || component->initialize(hostContext) != kResultOk) return false;
+
+	MemoryStream componentState;
+	component->getState(&componentState);
+	rewind(componentState);
+	component->setState(&componentState);
+
+	TUID controllerCid;
+	if (component->getControllerClassId(controllerCid) == kResultOk) {
+		IPtr<IEditController> controller = factory.createInstance<IEditController>(VST3::UID::fromTUID(controllerCid));
+		if (controller && controller->initialize(hostContext) == kResultOk) {
+			rewind(componentState);
+			controller->setComponentState(&componentState);
+			MemoryStream controllerState;
+			controller->getState(&controllerState);
+			rewind(controllerState);
+			controller->setState(&controllerState);
+			controller->terminate();
+		}
+	}
+
+	component->terminate();
+	return true;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+	int iterations = 100;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			iterations = std::max(1, std::atoi(argv[++i]));
+		else
+			paths.push_back(argv[i]);
+	}
+	if (paths.empty()) {
+		std::fprintf(stderr, "usage: %s [-n iterations] module.vst3 ...\n", argv[0]);
+		return 1;
+	}
+
+	IPtr<HostApplication> host = owned(new HostApplication());
+	int result = 0;
+	for (const std::string& path : paths) {
+		const Clock::time_point loadStart = Clock::now();
+		std::string error;
+		VST3::Hosting::Module::Ptr module = VST3::Hosting::Module::create(path, error);
+		if (!module) {
+			std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+			result = 1;
+			continue;
+		}
+		const VST3::Hosting::PluginFactory factory = module->getFactory();
+		const double loadTime = millisecondsSince(loadStart);
+
+		for (const VST3::Hosting::ClassInfo& classInfo : factory.classInfos()) {
+			if (classInfo.category() != kVstAudioEffectClass) continue;
+
+			const Clock::time_point start = Clock::now();
+			int succeeded = 0;
+			for (int i = 0; i < iterations; i++) {
+				if (scan(factory, classInfo, host)) succeeded++;
+			}
+			const double total = millisecondsSince(start);
+			if (succeeded < iterations) result = 1;
+
+			std::printf("%s: load %.3f ms, %d scans %.3f ms total, %.3f ms per scan%s\n", classInfo.name().c_str(), loadTime, iterations, total, total / iterations,
+				succeeded < iterations ? " (failed)" : "");
+		}
+	}
+	return result;
+}
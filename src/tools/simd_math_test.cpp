@@ -0,0 +1,119 @@
+// Accuracy test of the vectorized math functions (see simd_math.h)
+//  - sweeps random arguments over the domains of the error table in simd_math.h
+//  - fails if an error exceeds the documented bound
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <simd_math.h>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace Uberton;
+
+namespace {
+
+constexpr int numArguments = 1 << 20;
+constexpr int blockSize = 1027; // not a multiple of the vector width, the tail is processed as well
+
+// Error of value in units in the last place of T at the reference
+template<typename T>
+double ulpError(T value, long double reference) {
+	const T rounded = static_cast<T>(reference);
+	const T ulp = rounded == 0 ? std::numeric_limits<T>::denorm_min() : std::ldexp(T(1), std::ilogb(rounded) - (std::numeric_limits<T>::digits - 1));
+	return static_cast<double>(std::fabs(static_cast<long double>(value) - reference) / ulp);
+}
+
+struct Result
+{
+	double maxUlp{ 0 };
+	double maxAbsolute{ 0 };
+};
+
+// Evaluate f (array version) and reference for random arguments in [min, max]
+template<typename T, class F, class Reference>
+Result sweep(T min, T max, F&& f, Reference&& reference) {
+	std::mt19937_64 random(5489u);
+	std::uniform_real_distribution<T> distribution(min, max);
+	std::vector<T> x(blockSize), y(blockSize);
+	Result result;
+	for (int done = 0; done < numArguments; done += blockSize) {
+		for (T& value : x) value = distribution(random);
+		f(x.data(), y.data(), blockSize);
+		for (int i = 0; i < blockSize; i++) {
+			const long double expected = reference(static_cast<long double>(x[i]));
+			result.maxUlp = std::max(result.maxUlp, ulpError(y[i], expected));
+			result.maxAbsolute = std::max(result.maxAbsolute, static_cast<double>(std::fabs(static_cast<long double>(y[i]) - expected)));
+		}
+	}
+	return result;
+}
+
+int numFailures = 0;
+
+void check(const char* name, double error, double bound, const char* unit) {
+	const bool ok = error <= bound;
+	std::printf("%-32s %10.3g %-8s (bound %.3g)%s\n", name, error, unit, bound, ok ? "" : "  FAILED");
+	if (!ok) numFailures++;
+}
+
+template<typename T>
+void testType(const char* type, double trigUlp, T trigDomain, double trigFarUlp, double trigFarAbsolute, T expMin, T expMax, double expUlp, double tanhUlp) {
+	auto sinl = [](long double x) { return std::sin(x); };
+	auto cosl = [](long double x) { return std::cos(x); };
+	auto expl = [](long double x) { return std::exp(x); };
+	auto tanhl = [](long double x) { return std::tanh(x); };
+	auto sin = [](const T* x, T* out, int n) { Simd::sin(x, out, n); };
+	auto cos = [](const T* x, T* out, int n) { Simd::cos(x, out, n); };
+	auto exp = [](const T* x, T* out, int n) { Simd::exp(x, out, n); };
+	auto tanh = [](const T* x, T* out, int n) { Simd::tanh(x, out, n); };
+	// cexp() is composed of exp() and sincos()
+	std::vector<T> unused(blockSize);
+	auto sincosSin = [&](const T* x, T* out, int n) { Simd::sincos(x, out, unused.data(), n); };
+	auto sincosCos = [&](const T* x, T* out, int n) { Simd::sincos(x, unused.data(), out, n); };
+
+	char name[64];
+	auto label = [&](const char* function, const char* domain) {
+		std::snprintf(name, sizeof(name), "%s %s %s", type, function, domain);
+		return name;
+	};
+
+	check(label("sin", "|x| <= 4"), sweep<T>(-4, 4, sin, sinl).maxUlp, trigUlp, "ulp");
+	check(label("cos", "|x| <= 4"), sweep<T>(-4, 4, cos, cosl).maxUlp, trigUlp, "ulp");
+	check(label("sincos (sin)", "|x| <= 4"), sweep<T>(-4, 4, sincosSin, sinl).maxUlp, trigUlp, "ulp");
+	check(label("sincos (cos)", "|x| <= 4"), sweep<T>(-4, 4, sincosCos, cosl).maxUlp, trigUlp, "ulp");
+
+	const Result farSin = sweep<T>(-trigDomain, trigDomain, sin, sinl);
+	const Result farCos = sweep<T>(-trigDomain, trigDomain, cos, cosl);
+	if (trigFarUlp > 0) {
+		check(label("sin", "(full domain)"), farSin.maxUlp, trigFarUlp, "ulp");
+		check(label("cos", "(full domain)"), farCos.maxUlp, trigFarUlp, "ulp");
+	}
+	check(label("sin", "(full domain)"), farSin.maxAbsolute, trigFarAbsolute, "absolute");
+	check(label("cos", "(full domain)"), farCos.maxAbsolute, trigFarAbsolute, "absolute");
+
+	check(label("exp", ""), sweep<T>(expMin, expMax, exp, expl).maxUlp, expUlp, "ulp");
+	check(label("tanh", "|x| <= 1"), sweep<T>(-1, 1, tanh, tanhl).maxUlp, tanhUlp, "ulp");
+	check(label("tanh", "|x| <= 20"), sweep<T>(-20, 20, tanh, tanhl).maxUlp, tanhUlp, "ulp");
+}
+
+} // namespace
+
+
+int main() {
+	// the bounds of the table in simd_math.h
+	testType<float>("float", 1.6, 8192.f, 0, 0.8 * std::ldexp(1.0, -23), -87.f, 88.f, 1.0, 1.4);
+	testType<double>("double", 1.6, 1e6, 2.3, std::ldexp(1.0, -52), -708., 709., 1.7, 1.4);
+	return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+// Test of the voice pool and the note event queue (see voices.h)
+//  - the queue applies the events in the order of their offsets, also when it overflows
+//  - the pool steals released voices before held ones and reuses the voices freed by freeIf()
+//
+// -----------------------------------------------------------------------------------------------------------------------------
+// This file is part of the Überton project. Copyright (C) 2021 Überton
+//
+// Überton is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+// Überton is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should
+// have received a copy of the GNU General Public License along with Überton. If not, see http://www.gnu.org/licenses/.
+// -----------------------------------------------------------------------------------------------------------------------------
+
+
+#include <voices.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace Uberton;
+
+namespace {
+
+int numFailures = 0;
+
+void check(const char* name, bool ok) {
+	std::printf("%-60s %s\n", name, ok ? "ok" : "FAILED");
+	if (!ok) numFailures++;
+}
+
+// The events in the order they were applied and the rendered segments
+struct Log
+{
+	std::vector<NoteEvent> applied;
+	std::vector<std::pair<int, int>> rendered;
+
+	std::vector<int> pitches() const {
+		std::vector<int> result;
+		for (const auto& event : applied) result.push_back(event.pitch);
+		return result;
+	}
+
+	bool inOrder() const {
+		return std::is_sorted(applied.begin(), applied.end(), [](const NoteEvent& a, const NoteEvent& b) { return a.sampleOffset < b.sampleOffset; });
+	}
+
+	bool renderedContiguously(int numSamples) const {
+		int position = 0;
+		for (const auto& segment : rendered) {
+			if (segment.first != position || segment.second <= segment.first) return false;
+			position = segment.second;
+		}
+		return position == numSamples;
+	}
+};
+
+template<int capacity>
+Log pushAndProcess(const std::vector<NoteEvent>& events, int numSamples) {
+	NoteEventQueue<capacity> queue;
+	Log log;
+	auto apply = [&](const NoteEvent& event) { log.applied.push_back(event); };
+	for (const auto& event : events) {
+		queue.push(event, apply);
+	}
+	queue.process(numSamples, [&](int start, int end) { log.rendered.push_back({ start, end }); }, apply);
+	return log;
+}
+
+void testQueue() {
+	const int numSamples = 32;
+
+	Log log = pushAndProcess<4>({ { 20, 1, 1.f }, { 5, 2, 1.f }, { 5, 3, 0.f }, { 12, 4, 1.f } }, numSamples);
+	check("queue: unsorted events are applied sorted (stable)", log.pitches() == std::vector<int>{ 2, 3, 4, 1 } && log.inOrder());
+	check("queue: the block is rendered in segments between the events", log.rendered == std::vector<std::pair<int, int>>{ { 0, 5 }, { 5, 12 }, { 12, 20 }, { 20, 32 } });
+
+	// sorted events beyond the capacity keep their order, the first ones are applied early
+	std::vector<NoteEvent> sorted;
+	for (int k = 0; k < 8; k++) sorted.push_back({ 3 * k, k, 1.f });
+	log = pushAndProcess<3>(sorted, numSamples);
+	check("queue: sorted overflow keeps the order", log.pitches() == std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 } && log.inOrder());
+	check("queue: sorted overflow renders the whole block", log.renderedContiguously(numSamples));
+
+	// The event at 10 has to be applied early to make room for the one at 15. The event at 5
+	// arrives after that and cannot be applied before it anymore, so it is moved to 10.
+	log = pushAndProcess<2>({ { 10, 1, 1.f }, { 20, 2, 1.f }, { 15, 3, 1.f }, { 5, 4, 1.f } }, numSamples);
+	check("queue: unsorted overflow applies every event once", log.applied.size() == 4);
+	check("queue: unsorted overflow applies in the order of the offsets", log.inOrder());
+	check("queue: a late event is moved behind the early applied one", log.pitches() == std::vector<int>{ 1, 4, 3, 2 } && log.applied[1].sampleOffset == 10);
+
+	// an event that is earlier than all queued ones is applied right away, the queue stays intact
+	log = pushAndProcess<2>({ { 10, 1, 1.f }, { 20, 2, 1.f }, { 3, 3, 1.f } }, numSamples);
+	check("queue: an early event does not displace the queued ones", log.pitches() == std::vector<int>{ 3, 1, 2 } && log.inOrder());
+
+	// offsets of early applied events do not carry over to the next block
+	NoteEventQueue<1> queue;
+	Log carry;
+	auto apply = [&](const NoteEvent& event) { carry.applied.push_back(event); };
+	queue.push({ 10, 1, 1.f }, apply);
+	queue.push({ 20, 2, 1.f }, apply);
+	queue.flush(apply);
+	queue.push({ 0, 3, 1.f }, apply);
+	queue.flush(apply);
+	check("queue: flush() resets the offset of the early events", carry.applied.size() == 3 && carry.applied[2].sampleOffset == 0);
+}
+
+struct Voice
+{
+	float level{ 0 };
+	float energy() const { return level; }
+};
+
+void testPool() {
+	using Pool = VoicePool<Voice, 3>;
+	bool retriggered;
+
+	Pool pool;
+	const int a = pool.noteOn(60, retriggered);
+	const int b = pool.noteOn(61, retriggered);
+	const int c = pool.noteOn(62, retriggered);
+	pool[a].level = 1.f;
+	pool[b].level = 0.5f;
+	pool[c].level = 0.2f;
+	check("pool: a playing pitch is retriggered on its voice", pool.noteOn(61, retriggered) == b && retriggered);
+
+	// all voices are held, the oldest one (the retriggered 61 is younger) is stolen
+	check("pool: held voices are stolen oldest first", pool.noteOn(63, retriggered) == a && !retriggered);
+	check("pool: the stolen pitch is not mapped anymore", pool.noteOff(60) == Pool::noVoice);
+	pool[a].level = 1.f;
+
+	// the released voice is stolen although it is louder than the held ones and not the oldest
+	check("pool: note off releases the voice", pool.noteOff(61) == b && pool.isReleased(b));
+	pool[b].level = 2.f;
+	check("pool: released voices are stolen before held ones", pool.noteOn(64, retriggered) == b && !pool.isReleased(b));
+
+	// with several released voices, the quietest one is stolen
+	pool.noteOff(62);
+	pool.noteOff(63);
+	pool[c].level = 0.7f;
+	pool[a].level = 0.3f;
+	check("pool: the quietest released voice is stolen", pool.noteOn(65, retriggered) == a);
+	check("pool: all voices stay active while stealing", pool.getNumActive() == 3);
+
+	// free the voices in the middle and at the end of the active list
+	using BigPool = VoicePool<Voice, 8>;
+	BigPool big;
+	for (int pitch = 0; pitch < 6; pitch++) {
+		const int v = big.noteOn(pitch, retriggered);
+		big[v].level = static_cast<float>(pitch);
+	}
+	big.noteOff(1);
+	big.freeIf([](const Voice& voice) { return voice.level == 1.f || voice.level == 3.f || voice.level == 5.f; });
+	std::vector<float> levels;
+	big.forEachActive([&](Voice& voice) { levels.push_back(voice.level); });
+	std::sort(levels.begin(), levels.end());
+	check("pool: freeIf() keeps the other voices in the active list", levels == std::vector<float>{ 0.f, 2.f, 4.f } && big.getNumActive() == 3);
+	check("pool: freed held voices are unmapped", big.noteOff(3) == BigPool::noVoice && big.noteOff(2) != BigPool::noVoice);
+
+	// the freed voices are reused before stealing
+	int numActive = 0;
+	for (int pitch = 10; pitch < 15; pitch++) {
+		const int v = big.noteOn(pitch, retriggered);
+		numActive += big.isActive(v) ? 1 : 0;
+	}
+	check("pool: freed voices are reused", numActive == 5 && big.getNumActive() == 8);
+	big.freeIf([](const Voice&) { return true; });
+	int numVisited = 0;
+	big.forEachActive([&](Voice&) { numVisited++; });
+	check("pool: freeIf() can free all voices", big.getNumActive() == 0 && numVisited == 0);
+}
+
+} // namespace
+
+
+int main() {
+	testQueue();
+	testPool();
+	return numFailures > 0 ? 1 : 0;
+}